@@ -0,0 +1,257 @@
+#include "analytics.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace analytics {
+
+using namespace std;
+using namespace transport_catalogue;
+
+namespace {
+
+// Количество элементов в одном блоке обработки
+constexpr size_t CHUNK_SIZE = 256;
+
+// Минимальное количество блоков на поток. Блоки легкие, поэтому небольшие сети
+// обрабатываются в вызывающем потоке
+constexpr size_t MIN_CHUNKS_PER_THREAD = 8;
+
+// Обработка элементов блоками по CHUNK_SIZE, результат блока с номером i
+// записывается в позицию i
+template <typename Partial, typename Item, typename Function>
+vector<Partial> ProcessChunks(const vector<Item>& items, Function process_chunk) {
+	return parallel::MapChunks<Partial>(items.size(), CHUNK_SIZE, MIN_CHUNKS_PER_THREAD, process_chunk);
+}
+
+// Порядок рейтинга: по убыванию значения, затем по названию
+bool RankedBefore(const RankedItem& lhs, const RankedItem& rhs) {
+	if (lhs.value != rhs.value) {
+		return lhs.value > rhs.value;
+	}
+	return lexicographical_compare(lhs.name.begin(), lhs.name.end(), rhs.name.begin(), rhs.name.end());
+}
+
+// Добавление элементов в рейтинг с сохранением только первых count
+void MergeTop(vector<RankedItem>& top, const vector<RankedItem>& items, size_t count) {
+	top.insert(top.end(), items.begin(), items.end());
+	const size_t keep = min(count, top.size());
+	partial_sort(top.begin(), top.begin() + keep, top.end(), RankedBefore);
+	top.resize(keep);
+}
+
+// Значение по рангу в отсортированном списке
+double Percentile(const vector<double>& sorted_values, double share) {
+	const size_t rank = static_cast<size_t>(ceil(share * sorted_values.size()));
+	return sorted_values[rank > 0 ? rank - 1 : 0];
+}
+
+// Распределение значений. Список значений сортируется. Неконечные значения (извилистость
+// маршрута нулевой географической длины) пропускаются, sum - сумма остальных значений
+Distribution Describe(vector<double>& values, double sum) {
+	values.erase(remove_if(values.begin(), values.end(), [](double value) { return !isfinite(value); }), values.end());
+
+	Distribution result;
+	if (values.empty()) {
+		return result;
+	}
+
+	sort(values.begin(), values.end());
+
+	result.min = values.front();
+	result.max = values.back();
+	result.mean = sum / values.size();
+	result.median = Percentile(values, 0.5);
+	result.p90 = Percentile(values, 0.9);
+
+	return result;
+}
+
+// Частичный результат по блоку маршрутов
+struct BusPartial {
+	int64_t route_length = 0;
+	double geo_length = 0.0;
+	double curvature = 0.0;
+	int64_t stop_count = 0;
+
+	vector<RankedItem> longest;
+	vector<RankedItem> most_curved;
+	vector<RankedItem> busiest;
+};
+
+// Частичный результат по блоку остановок
+struct StopPartial {
+	int64_t bus_count = 0;
+	vector<RankedItem> busiest;
+};
+
+} // End of namespace
+
+// Расчет статистики сети за один проход по маршрутам и остановкам каталога
+NetworkStats ComputeNetworkStats(const TransportCatalogue& catalogue, size_t top_count) {
+	NetworkStats result;
+
+	const vector<const Bus*> buses = catalogue.GetBusList();
+	const vector<const Stop*> stops = catalogue.GetStopList();
+	result.bus_count = buses.size();
+	result.stop_count = stops.size();
+
+	// Значения по маршрутам и остановкам для распределений. Блоки пишут
+	// в непересекающиеся участки, поэтому синхронизация не нужна
+	vector<double> route_lengths(buses.size());
+	vector<double> curvatures(buses.size());
+	vector<double> stop_counts(buses.size());
+	vector<double> buses_per_stop(stops.size());
+
+	const vector<BusPartial> bus_partials = ProcessChunks<BusPartial>(buses, [&](size_t begin, size_t end) {
+		BusPartial partial;
+		vector<RankedItem> longest, most_curved, busiest;
+
+		for (size_t i = begin; i < end; ++i) {
+			const BusStat& stat = catalogue.GetBusStat(buses[i]);
+
+			route_lengths[i] = stat.route_length;
+			curvatures[i] = stat.curvature;
+			stop_counts[i] = stat.stop_count;
+
+			partial.route_length += stat.route_length;
+			partial.geo_length += stat.geo_length;
+			partial.stop_count += stat.stop_count;
+
+			longest.push_back({ buses[i]->name_, static_cast<double>(stat.route_length) });
+
+			// У маршрута нулевой географической длины извилистости нет
+			if (isfinite(stat.curvature)) {
+				partial.curvature += stat.curvature;
+				most_curved.push_back({ buses[i]->name_, stat.curvature });
+			}
+
+			busiest.push_back({ buses[i]->name_, static_cast<double>(stat.stop_count) });
+		}
+
+		MergeTop(partial.longest, longest, top_count);
+		MergeTop(partial.most_curved, most_curved, top_count);
+		MergeTop(partial.busiest, busiest, top_count);
+
+		return partial;
+	});
+
+	const vector<StopPartial> stop_partials = ProcessChunks<StopPartial>(stops, [&](size_t begin, size_t end) {
+		StopPartial partial;
+		vector<RankedItem> busiest;
+
+		for (size_t i = begin; i < end; ++i) {
+			const auto* stop_buses = catalogue.GetBusesToStop(stops[i]->name_);
+			const size_t bus_count = stop_buses != nullptr ? stop_buses->size() : 0;
+
+			buses_per_stop[i] = static_cast<double>(bus_count);
+			partial.bus_count += bus_count;
+			busiest.push_back({ stops[i]->name_, static_cast<double>(bus_count) });
+		}
+
+		MergeTop(partial.busiest, busiest, top_count);
+
+		return partial;
+	});
+
+	// Объединение результатов блоков
+	double curvature_sum = 0.0;
+	for (const BusPartial& partial : bus_partials) {
+		result.total_route_length += partial.route_length;
+		result.total_geo_length += partial.geo_length;
+		result.total_stop_count += partial.stop_count;
+		curvature_sum += partial.curvature;
+
+		MergeTop(result.longest_buses, partial.longest, top_count);
+		MergeTop(result.most_curved_buses, partial.most_curved, top_count);
+		MergeTop(result.busiest_buses, partial.busiest, top_count);
+	}
+
+	int64_t stop_bus_sum = 0;
+	for (const StopPartial& partial : stop_partials) {
+		stop_bus_sum += partial.bus_count;
+		MergeTop(result.busiest_stops, partial.busiest, top_count);
+	}
+
+	result.route_length = Describe(route_lengths, static_cast<double>(result.total_route_length));
+	result.curvature = Describe(curvatures, curvature_sum);
+	result.stop_count_per_bus = Describe(stop_counts, static_cast<double>(result.total_stop_count));
+	result.buses_per_stop = Describe(buses_per_stop, static_cast<double>(stop_bus_sum));
+
+	return result;
+}
+
+// Сравнение способа расчета расстояний со сферическим на отрезках маршрутов
+DistanceAccuracy MeasureDistanceAccuracy(const TransportCatalogue& catalogue, geo::DistanceMode mode) {
+	DistanceAccuracy result;
+
+	const geo::PointArrays points = catalogue.GetStopPoints();
+	const vector<const Bus*> buses = catalogue.GetBusList();
+
+	vector<double> reference;
+	vector<double> approximate;
+	double abs_error_sum = 0.0;
+
+	for (const Bus* bus : buses) {
+		const StopSequence& stops = bus->stops_;
+		if (stops.size() < 2) {
+			continue;
+		}
+
+		reference.resize(stops.size() - 1);
+		approximate.resize(stops.size() - 1);
+		geo::ComputeSegmentDistances(points, stops.GetIds(), stops.size(), reference.data());
+		geo::ComputeSegmentDistances(points, stops.GetIds(), stops.size(), approximate.data(), mode);
+
+		for (size_t i = 0; i < reference.size(); ++i) {
+			const double abs_error = abs(approximate[i] - reference[i]);
+			result.max_abs_error = max(result.max_abs_error, abs_error);
+			abs_error_sum += abs_error;
+			if (reference[i] > 0.0) {
+				result.max_rel_error = max(result.max_rel_error, abs_error / reference[i]);
+			}
+		}
+		result.segment_count += reference.size();
+	}
+
+	if (result.segment_count == 0) {
+		return result;
+	}
+	result.mean_abs_error = abs_error_sum / result.segment_count;
+
+	// Количество проходов подбирается так, чтобы всего было около миллиона отрезков
+	const size_t pass_count = max<size_t>(1, 1'000'000 / result.segment_count);
+	auto measure = [&](geo::DistanceMode measured_mode) {
+		vector<double> distances;
+		double checksum = 0.0;
+
+		const auto start = chrono::steady_clock::now();
+		for (size_t pass = 0; pass < pass_count; ++pass) {
+			for (const Bus* bus : buses) {
+				const StopSequence& stops = bus->stops_;
+				if (stops.size() < 2) {
+					continue;
+				}
+				distances.resize(stops.size() - 1);
+				geo::ComputeSegmentDistances(points, stops.GetIds(), stops.size(), distances.data(), measured_mode);
+				checksum += distances.back();
+			}
+		}
+		const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+		// Контрольная сумма не дает компилятору убрать расчет
+		volatile double sink = checksum;
+		(void)sink;
+
+		return elapsed.count() / (pass_count * result.segment_count);
+	};
+
+	result.mode_ns_per_segment = measure(mode);
+	result.reference_ns_per_segment = measure(geo::DistanceMode::SPHERICAL);
+
+	return result;
+}
+
+} // End of analytics
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace analytics {
+
+// Распределение значения по маршрутам или остановкам.
+// Медиана и 90-й процентиль берутся по рангу из отсортированных значений
+struct Distribution {
+	double min = 0.0;
+	double max = 0.0;
+	double mean = 0.0;
+	double median = 0.0;
+	double p90 = 0.0;
+};
+
+// Элемент рейтинга: название маршрута или остановки и значение показателя
+struct RankedItem {
+	std::string_view name;
+	double value = 0.0;
+};
+
+// Сводная статистика по всей сети маршрутов
+struct NetworkStats {
+	size_t stop_count = 0;
+	size_t bus_count = 0;
+
+	// Суммы по всем маршрутам
+	int64_t total_route_length = 0;
+	double total_geo_length = 0.0;
+	int64_t total_stop_count = 0;
+
+	// Распределения длины, извилистости и количества остановок маршрутов
+	// и количества маршрутов через остановку
+	Distribution route_length;
+	Distribution curvature;
+	Distribution stop_count_per_bus;
+	Distribution buses_per_stop;
+
+	// Первые top_count маршрутов и остановок по убыванию показателя.
+	// При равенстве значений порядок - по названию
+	std::vector<RankedItem> longest_buses;
+	std::vector<RankedItem> most_curved_buses;
+	std::vector<RankedItem> busiest_buses;
+	std::vector<RankedItem> busiest_stops;
+};
+
+// Расчет статистики сети за один проход по маршрутам и остановкам каталога.
+// Маршруты и остановки обрабатываются блоками в нескольких потоках, результаты блоков
+// объединяются в порядке блоков, поэтому не зависят от количества потоков.
+// Используется статистика маршрутов, сохраненная в каталоге
+NetworkStats ComputeNetworkStats(const transport_catalogue::TransportCatalogue& catalogue, size_t top_count);
+
+// Точность и скорость приближенного способа расчета расстояний относительно
+// сферической теоремы косинусов на отрезках маршрутов каталога
+struct DistanceAccuracy {
+	size_t segment_count = 0;
+
+	// Ошибки в метрах и относительная ошибка. Отрезки нулевой длины
+	// в относительной ошибке не учитываются
+	double max_abs_error = 0.0;
+	double mean_abs_error = 0.0;
+	double max_rel_error = 0.0;
+
+	// Время пакетного расчета одного отрезка в наносекундах
+	double mode_ns_per_segment = 0.0;
+	double reference_ns_per_segment = 0.0;
+};
+
+// Сравнение способа расчета mode со сферическим на всех отрезках между соседними
+// остановками маршрутов. Время измеряется по нескольким проходам пакетного расчета
+DistanceAccuracy MeasureDistanceAccuracy(const transport_catalogue::TransportCatalogue& catalogue,
+	geo::DistanceMode mode);
+
+} // End of analytics
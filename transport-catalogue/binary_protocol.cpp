@@ -0,0 +1,257 @@
+#include "binary_protocol.h"
+
+#include <transport_requests.pb.h>
+
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <variant>
+
+namespace binary_protocol {
+
+using namespace std;
+using namespace transport_catalogue;
+
+namespace details {
+
+optional<ClosedNames> DecodeClosedNames(bool has_closed, const transport_requests::ClosedNames& closed) {
+	if (!has_closed) {
+		return nullopt;
+	}
+	return ClosedNames{
+		{ closed.stops().begin(), closed.stops().end() },
+		{ closed.buses().begin(), closed.buses().end() } };
+}
+
+// Неизвестное значение kind - ошибка разбора запроса, как и в формате JSON
+AutocompleteKind DecodeAutocompleteKind(transport_requests::AutocompleteRequest::Kind kind) {
+	switch (kind) {
+	case transport_requests::AutocompleteRequest::STOP:
+		return AutocompleteKind::STOP;
+	case transport_requests::AutocompleteRequest::BUS:
+		return AutocompleteKind::BUS;
+	default:
+		throw invalid_argument("Unknown autocomplete kind "s + to_string(kind));
+	}
+}
+
+// Запрос из сообщения в структуру его типа, как при чтении запроса из JSON
+RequestInfo DecodeRequest(const transport_requests::Request& message) {
+	using Message = transport_requests::Request;
+
+	RequestInfo request;
+	request.id = message.id();
+
+	switch (message.type_case()) {
+	case Message::kStop:
+		request.fields = StopRequest{ message.stop().name() };
+		break;
+	case Message::kBus:
+		request.fields = BusRequest{ message.bus().name(),
+			DecodeClosedNames(message.bus().has_closed(), message.bus().closed()) };
+		break;
+	case Message::kRoute:
+		request.fields = RouteRequest{ message.route().from(), message.route().to(),
+			DecodeClosedNames(message.route().has_closed(), message.route().closed()) };
+		break;
+	case Message::kNearestStops:
+		request.fields = NearestStopsRequest{
+			{ message.nearest_stops().latitude(), message.nearest_stops().longitude() },
+			message.nearest_stops().count() };
+		break;
+	case Message::kAutocomplete:
+		request.fields = AutocompleteRequest{
+			DecodeAutocompleteKind(message.autocomplete().kind()), message.autocomplete().prefix(), message.autocomplete().count() };
+		break;
+	case Message::kDirectBuses:
+		request.fields = DirectBusesRequest{ message.direct_buses().from(), message.direct_buses().to() };
+		break;
+	case Message::kAnalytics: {
+		AnalyticsRequest analytics;
+		if (message.analytics().has_count()) {
+			analytics.count = message.analytics().count();
+		}
+		request.fields = analytics;
+		break;
+	}
+	case Message::kStats:
+		request.fields = StatsRequest{};
+		break;
+	case Message::kMap:
+		request.fields = MapRequest{};
+		break;
+	case Message::TYPE_NOT_SET:
+		throw invalid_argument("Request "s + to_string(message.id()) + " has no type"s);
+	}
+
+	return request;
+}
+
+void FillStopResponse(const set<const Bus*>* buses, transport_requests::Response& response) {
+	if (buses == nullptr) {
+		response.set_error_message("not found"s);
+		return;
+	}
+
+	// Названия по алфавиту, как в ответе JSON
+	set<string_view> bus_names;
+	for (const Bus* bus : *buses) {
+		bus_names.insert(bus->name_);
+	}
+
+	auto& stop = *response.mutable_stop();
+	for (string_view bus_name : bus_names) {
+		stop.add_buses(string(bus_name));
+	}
+}
+
+void FillBusResponse(const optional<BusStat>& bus_info, transport_requests::Response& response) {
+	if (!bus_info) {
+		response.set_error_message("not found"s);
+		return;
+	}
+
+	auto& bus = *response.mutable_bus();
+	bus.set_curvature(bus_info->curvature);
+	bus.set_route_length(bus_info->route_length);
+	bus.set_stop_count(bus_info->stop_count);
+	bus.set_unique_stop_count(bus_info->unique_stop_count);
+}
+
+void FillRouteResponse(const optional<transport_router::RouteResponce>& route_info,
+	transport_requests::Response& response) {
+	if (!route_info) {
+		response.set_error_message("not found"s);
+		return;
+	}
+
+	auto& route = *response.mutable_route();
+	route.set_total_time(route_info->total_time);
+
+	for (const auto& element : route_info->items) {
+		auto& item = *route.add_items();
+		if (element.type == "Wait"sv) {
+			item.set_type(transport_requests::RouteItem::WAIT);
+			item.set_name(string(element.stop_name));
+			item.set_time(route_info->bus_wait_time);
+		}
+		else if (element.type == "Bus"sv) {
+			item.set_type(transport_requests::RouteItem::BUS);
+			item.set_name(string(element.bus_name));
+			item.set_span_count(element.span_count);
+			item.set_time(element.time);
+		}
+		else {
+			throw logic_error("Unknown route list item type"s);
+		}
+	}
+}
+
+// Ответ на запрос в сообщении Response
+transport_requests::Response MakeResponse(request_handler::RequestHandler& handler, const RequestInfo& request) {
+	transport_requests::Response response;
+	response.set_request_id(request.id);
+
+	switch (request.GetType()) {
+	case RequestType::STOP:
+		FillStopResponse(handler.GetBusesByStop(get<StopRequest>(request.fields).name), response);
+		break;
+	case RequestType::BUS:
+		FillBusResponse(handler.GetBusInfo(get<BusRequest>(request.fields)), response);
+		break;
+	case RequestType::ROUTE:
+		FillRouteResponse(handler.GetRoute(get<RouteRequest>(request.fields)), response);
+		break;
+	case RequestType::NEAREST_STOPS: {
+		const auto& nearest = get<NearestStopsRequest>(request.fields);
+		auto& stops = *response.mutable_nearest_stops();
+		for (const NearestStop& stop : handler.GetNearestStops(nearest.location, nearest.count)) {
+			auto& item = *stops.add_stops();
+			item.set_name(string(stop.stop->name_));
+			item.set_distance(stop.distance);
+		}
+		break;
+	}
+	case RequestType::AUTOCOMPLETE: {
+		const auto& autocomplete = get<AutocompleteRequest>(request.fields);
+		auto& items = *response.mutable_autocomplete();
+		for (string_view name : handler.Autocomplete(autocomplete.kind, autocomplete.prefix, autocomplete.count)) {
+			items.add_items(string(name));
+		}
+		break;
+	}
+	case RequestType::DIRECT_BUSES: {
+		const auto& direct = get<DirectBusesRequest>(request.fields);
+		const auto direct_buses = handler.GetDirectBuses(direct.from, direct.to);
+		if (!direct_buses) {
+			response.set_error_message("not found"s);
+			break;
+		}
+
+		auto& buses = *response.mutable_direct_buses();
+		for (const DirectBus& direct_bus : *direct_buses) {
+			auto& item = *buses.add_buses();
+			item.set_bus(string(direct_bus.bus->name_));
+			item.set_span_count(direct_bus.span_count);
+			item.set_time(handler.GetRideTime(direct_bus.distance));
+		}
+		break;
+	}
+	case RequestType::ANALYTICS:
+		[[fallthrough]];
+	case RequestType::STATS:
+		[[fallthrough]];
+	case RequestType::REMOVE_STOP:
+		[[fallthrough]];
+	case RequestType::REMOVE_BUS:
+		[[fallthrough]];
+	case RequestType::SET_DISTANCE: {
+		// Отчеты намеренно передаются текстом ответа JSON, как в режиме JSON: набор частей
+		// в них открытый, а ответ нужен для диагностики, а не для разбора клиентом.
+		// Запросы изменения базы в протоколе не описаны и сюда не попадают
+		ostringstream strm;
+		json::PrintCompact(handler.GetResponse(request), strm);
+		response.set_json(strm.str());
+		break;
+	}
+	case RequestType::MAP: {
+		ostringstream strm;
+		handler.RenderMap().Render(strm);
+		response.mutable_map()->set_map(strm.str());
+		break;
+	}
+	}
+
+	return response;
+}
+
+} // End of details
+
+RequestBatch ReadRequestBatch(istream& input) {
+	transport_requests::RequestBatch message;
+	if (!message.ParseFromIstream(&input)) {
+		throw invalid_argument("Can't parse request batch"s);
+	}
+
+	RequestBatch result;
+	result.ser_settings.file_name = message.database_file();
+	for (const auto& request : message.requests()) {
+		result.requests.push_back(details::DecodeRequest(request));
+	}
+
+	return result;
+}
+
+void WriteResponses(request_handler::RequestHandler& handler, const deque<RequestInfo>& requests, ostream& output) {
+	for (const RequestInfo& request : requests) {
+		const transport_requests::Response response = details::MakeResponse(handler, request);
+		if (!google::protobuf::util::SerializeDelimitedToOstream(response, &output)) {
+			throw runtime_error("Can't write response"s);
+		}
+	}
+}
+
+} // End of binary_protocol
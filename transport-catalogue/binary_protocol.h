@@ -0,0 +1,30 @@
+#pragma once
+
+#include "domain.h"
+#include "request_handler.h"
+#include "serialization.h"
+
+#include <deque>
+#include <iostream>
+
+/*
+ * Двоичный протокол запросов stat_requests и ответов на них (transport_requests.proto).
+ * Семантика запросов и ответов совпадает с форматом JSON
+ */
+namespace binary_protocol {
+
+// Содержимое пакета запросов RequestBatch
+struct RequestBatch {
+	serialization::Settings ser_settings;
+	std::deque<transport_catalogue::RequestInfo> requests;
+};
+
+// Чтение пакета запросов. Поток целиком содержит одно сообщение RequestBatch
+RequestBatch ReadRequestBatch(std::istream& input);
+
+// Вывод ответов сообщениями Response. Каждое сообщение выводится сразу после формирования
+// с длиной в начале (varint), как в google::protobuf::util::SerializeDelimitedToOstream
+void WriteResponses(request_handler::RequestHandler& handler,
+	const std::deque<transport_catalogue::RequestInfo>& requests, std::ostream& output);
+
+} // End of binary_protocol
@@ -12,7 +12,12 @@
  *
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <variant>
 #include <vector>
 #include <string_view>
 #include <deque>
@@ -23,12 +28,108 @@
 
 namespace transport_catalogue {
 
-// Контейнер информации для одного зароса к каталогу
+// Сценарий запроса: названия закрытых остановок и маршрутов (поля closed_stops и closed_buses)
+struct ClosedNames {
+	std::vector<std::string> stops;
+	std::vector<std::string> buses;
+};
+
+// Поля запросов stat_requests по типам
+struct StopRequest {
+	std::string name;
+};
+
+struct BusRequest {
+	std::string name;
+	std::optional<ClosedNames> closed;
+};
+
+struct RouteRequest {
+	std::string from;
+	std::string to;
+	std::optional<ClosedNames> closed;
+};
+
+struct NearestStopsRequest {
+	geo::Coordinates location;
+	size_t count = 0;
+};
+
+// Список, в котором ищутся названия для запроса Autocomplete (поле kind)
+enum class AutocompleteKind {
+	STOP,
+	BUS,
+};
+
+struct AutocompleteRequest {
+	AutocompleteKind kind = AutocompleteKind::STOP;
+	std::string prefix;
+	size_t count = 0;
+};
+
+struct DirectBusesRequest {
+	std::string from;
+	std::string to;
+};
+
+struct AnalyticsRequest {
+	// Размер рейтингов
+	size_t count = 5;
+};
+
+struct StatsRequest {
+};
+
+struct MapRequest {
+};
+
+// Запросы изменения базы
+struct RemoveStopRequest {
+	std::string name;
+};
+
+struct RemoveBusRequest {
+	std::string name;
+};
+
+struct SetDistanceRequest {
+	std::string from;
+	std::string to;
+	int distance = 0;
+};
+
+// Тип запроса. Значения совпадают с номерами вариантов RequestInfo::fields
+enum class RequestType {
+	STOP,
+	BUS,
+	ROUTE,
+	NEAREST_STOPS,
+	AUTOCOMPLETE,
+	DIRECT_BUSES,
+	ANALYTICS,
+	STATS,
+	MAP,
+	REMOVE_STOP,
+	REMOVE_BUS,
+	SET_DISTANCE,
+};
+
+// Контейнер информации для одного зароса к каталогу. Поля разбираются один раз
+// при чтении запроса и хранятся в структуре его типа
 struct RequestInfo {
-	int id;
-	std::unordered_map<std::string, std::string> request_items;
+	int id = 0;
+	std::variant<StopRequest, BusRequest, RouteRequest, NearestStopsRequest, AutocompleteRequest,
+		DirectBusesRequest, AnalyticsRequest, StatsRequest, MapRequest,
+		RemoveStopRequest, RemoveBusRequest, SetDistanceRequest> fields;
+
+	RequestType GetType() const {
+		return static_cast<RequestType>(fields.index());
+	}
 };
 
+static_assert(std::variant_size_v<decltype(RequestInfo::fields)> == static_cast<size_t>(RequestType::SET_DISTANCE) + 1,
+	"RequestType must list all alternatives of RequestInfo::fields");
+
 // Запрос на добавление остановки
 struct StopToAdd {
 	std::string name;
@@ -44,17 +145,140 @@ struct BusToAdd {
 };
 
 
-// Инфомарция об остановке
+// Инфомарция об остановке. Название ссылается на строку в арене названий каталога
 struct Stop {
-	std::string name_;
+	std::string_view name_;
 	geo::Coordinates location_;
+	// Номер остановки в каталоге
+	uint32_t id_ = 0;
 };
 
-// Информация о маршруте
+// Последовательность остановок маршрута. Номера остановок всех маршрутов хранятся
+// подряд в общем массиве каталога, а последовательность ссылается на свой участок
+// и получает остановки по номерам. Отраженная последовательность проходит участок
+// туда и обратно без копирования: так задается полный путь линейного маршрута
+class StopSequence {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = const Stop*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Stop* const*;
+		using reference = const Stop*;
+
+		Iterator() = default;
+		Iterator(const StopSequence* sequence, size_t index)
+			: sequence_(sequence), index_(index) {}
+
+		reference operator*() const { return (*sequence_)[index_]; }
+		reference operator[](difference_type offset) const { return (*sequence_)[index_ + offset]; }
+
+		Iterator& operator++() { ++index_; return *this; }
+		Iterator operator++(int) { Iterator result = *this; ++index_; return result; }
+		Iterator& operator--() { --index_; return *this; }
+		Iterator operator--(int) { Iterator result = *this; --index_; return result; }
+		Iterator& operator+=(difference_type offset) { index_ += offset; return *this; }
+		Iterator& operator-=(difference_type offset) { index_ -= offset; return *this; }
+		Iterator operator+(difference_type offset) const { return { sequence_, index_ + offset }; }
+		Iterator operator-(difference_type offset) const { return { sequence_, index_ - offset }; }
+		difference_type operator-(const Iterator& other) const {
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+
+		bool operator==(const Iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+		bool operator<(const Iterator& other) const { return index_ < other.index_; }
+		bool operator>(const Iterator& other) const { return index_ > other.index_; }
+		bool operator<=(const Iterator& other) const { return index_ <= other.index_; }
+		bool operator>=(const Iterator& other) const { return index_ >= other.index_; }
+
+	private:
+		const StopSequence* sequence_ = nullptr;
+		size_t index_ = 0;
+	};
+
+	StopSequence() = default;
+
+	// Участок [offset, offset + size) массива номеров ids. Номера - позиции в stops
+	StopSequence(const std::vector<uint32_t>* ids, size_t offset, size_t size, const std::deque<Stop>* stops,
+		bool mirrored = false)
+		: ids_(ids), stops_(stops), offset_(offset), size_(size), mirrored_(mirrored) {}
+
+	size_t size() const {
+		return mirrored_ && size_ > 0 ? 2 * size_ - 1 : size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	// Номер остановки на позиции. Вторая половина отраженной последовательности
+	// проходит участок в обратном порядке
+	uint32_t GetId(size_t index) const {
+		if (index >= size_) {
+			index = 2 * size_ - 2 - index;
+		}
+		return (*ids_)[offset_ + index];
+	}
+
+	const Stop* operator[](size_t index) const {
+		return &(*stops_)[GetId(index)];
+	}
+
+	const Stop* front() const {
+		return (*this)[0];
+	}
+
+	const Stop* back() const {
+		return (*this)[size() - 1];
+	}
+
+	Iterator begin() const {
+		return { this, 0 };
+	}
+
+	Iterator end() const {
+		return { this, size() };
+	}
+
+	// Номера остановок участка подряд. Для отраженной последовательности
+	// возвращает только прямой ход
+	const uint32_t* GetIds() const {
+		return ids_->data() + offset_;
+	}
+
+	// Отраженная последовательность: участок туда и обратно
+	StopSequence Mirrored() const {
+		return { ids_, offset_, size_, stops_, true };
+	}
+
+	// Положение участка в общем массиве номеров
+	size_t GetOffset() const {
+		return offset_;
+	}
+
+private:
+	const std::vector<uint32_t>* ids_ = nullptr;
+	const std::deque<Stop>* stops_ = nullptr;
+	size_t offset_ = 0;
+	size_t size_ = 0;
+	bool mirrored_ = false;
+};
+
+// Информация о маршруте. Название ссылается на строку в арене названий каталога
 struct Bus {
 	bool is_circle_ = false;
-	std::string name_;
-	std::vector<const Stop*> stops_;
+	std::string_view name_;
+	// Остановки маршрута в том виде, в котором они заданы в базе
+	StopSequence stops_;
+	// Номер маршрута в каталоге
+	uint32_t id_ = 0;
+
+	// Полный путь маршрута: линейный маршрут проходится туда и обратно
+	StopSequence GetRoute() const {
+		return is_circle_ ? stops_ : stops_.Mirrored();
+	}
 };
 
 struct StopsDistance {
@@ -71,6 +295,61 @@ struct BusStat {
 	int route_length;
 	int stop_count;
 	int unique_stop_count;
+	// Географическая длина маршрута, по которой считается извилистость
+	double geo_length = 0.0;
+};
+
+// Ближайшая к точке остановка и расстояние до нее в метрах
+struct NearestStop {
+	const Stop* stop;
+	double distance;
+};
+
+// Сценарий "что если" поверх неизменяемой базы: закрытые остановки и маршруты
+// по их номерам. Остановки и маршруты с номерами вне списков открыты
+struct Closures {
+	std::vector<bool> closed_stops;
+	std::vector<bool> closed_buses;
+
+	bool IsClosed(const Stop* stop) const {
+		return stop->id_ < closed_stops.size() && closed_stops[stop->id_];
+	}
+
+	bool IsClosed(const Bus* bus) const {
+		return bus->id_ < closed_buses.size() && closed_buses[bus->id_];
+	}
+};
+
+// Маршрут без пересадок между двумя остановками: длина поездки в метрах и
+// количество перегонов на самом коротком участке маршрута от первой остановки до второй
+struct DirectBus {
+	const Bus* bus;
+	int distance;
+	int span_count;
+};
+
+// Данные всех остановок в виде параллельных массивов по номерам остановок.
+// Позволяет обходить координаты подряд, не затрагивая остальные поля остановок.
+// Удаленные остановки остаются в массивах
+struct StopArrays {
+	const double* lat = nullptr;
+	const double* lng = nullptr;
+	const std::string_view* names = nullptr;
+	size_t size = 0;
+};
+
+// Заранее сформированный ответ на запрос. Полный ответ - это head,
+// номер запроса и tail
+struct ResponseTemplate {
+	std::string head;
+	std::string tail;
+};
+
+// Заранее сформированные ответы на запросы Stop и Bus по номерам остановок и маршрутов.
+// Ответ, сброшенный после изменения базы, пуст
+struct MaterializedResponses {
+	std::vector<ResponseTemplate> stops;
+	std::vector<ResponseTemplate> buses;
 };
 
 // Ответ на запрос по остановке
@@ -1,21 +1,144 @@
 ﻿#define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
     static const int EARTH_RADUIS = 6371000;
 
+    namespace {
+
+        const double dr = M_PI / 180.;
+
+        // Разность долгот в градусах с учетом перехода через 180-й меридиан
+        double LongitudeDelta(double from_lng, double to_lng) {
+            const double delta = std::abs(from_lng - to_lng);
+            return std::min(delta, 360. - delta);
+        }
+
+        // Расстояние по формуле гаверсинусов
+        double HaversineDistance(double delta_lat, double delta_lng, double cos_from, double cos_to) {
+            const double sin_lat = std::sin(delta_lat * dr / 2.);
+            const double sin_lng = std::sin(delta_lng * dr / 2.);
+            const double a = sin_lat * sin_lat + cos_from * cos_to * sin_lng * sin_lng;
+            return 2. * std::asin(std::sqrt(std::min(a, 1.))) * EARTH_RADUIS;
+        }
+
+        // Расстояние в равнопромежуточной проекции. Косинус средней широты
+        // заменен средним косинусов концов отрезка: для отрезков в пределах города
+        // разница пренебрежимо мала, а тригонометрия на отрезок не нужна
+        double EquirectangularDistance(double delta_lat, double delta_lng, double cos_from, double cos_to) {
+            const double x = delta_lng * dr * (cos_from + cos_to) / 2.;
+            const double y = delta_lat * dr;
+            return std::sqrt(x * x + y * y) * EARTH_RADUIS;
+        }
+
+        // Расчет расстояний между соседними точками цепочки приближенным способом.
+        // Функция расстояния - параметр шаблона, чтобы она встраивалась в цикл
+        template <double (*Distance)(double, double, double, double)>
+        void ComputeApproximateDistances(const PointArrays& points, const uint32_t* ids, size_t segment_count,
+            double* distances) {
+            for (size_t i = 0; i < segment_count; ++i) {
+                const uint32_t from = ids[i];
+                const uint32_t to = ids[i + 1];
+                distances[i] = Distance(std::abs(points.lat[from] - points.lat[to]),
+                    LongitudeDelta(points.lng[from], points.lng[to]),
+                    points.cos_lat[from], points.cos_lat[to]);
+            }
+        }
+
+    } // End of namespace
+
+    std::string_view GetDistanceModeName(DistanceMode mode) {
+        switch (mode) {
+        case DistanceMode::HAVERSINE:
+            return "haversine";
+        case DistanceMode::EQUIRECTANGULAR:
+            return "equirectangular";
+        default:
+            return "spherical";
+        }
+    }
+
+    std::optional<DistanceMode> ParseDistanceMode(std::string_view name) {
+        for (DistanceMode mode : { DistanceMode::SPHERICAL, DistanceMode::HAVERSINE, DistanceMode::EQUIRECTANGULAR }) {
+            if (GetDistanceModeName(mode) == name) {
+                return mode;
+            }
+        }
+        return std::nullopt;
+    }
+
     double ComputeDistance(Coordinates from, Coordinates to) {
         using namespace std;
         if (from == to) {
             return 0;
         }
-        static const double dr = M_PI / 180.;
         return acos(sin(from.lat * dr) * sin(to.lat * dr)
             + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
             * EARTH_RADUIS;
     }
 
+    LatitudeTrig ComputeLatitudeTrig(double lat) {
+        return { std::sin(lat * dr), std::cos(lat * dr) };
+    }
+
+    double ComputeDistance(Coordinates from, Coordinates to, DistanceMode mode) {
+        if (mode == DistanceMode::SPHERICAL) {
+            return ComputeDistance(from, to);
+        }
+
+        const double delta_lat = std::abs(from.lat - to.lat);
+        const double delta_lng = LongitudeDelta(from.lng, to.lng);
+        const double cos_from = ComputeLatitudeTrig(from.lat).cos_lat;
+        const double cos_to = ComputeLatitudeTrig(to.lat).cos_lat;
+
+        return mode == DistanceMode::HAVERSINE
+            ? HaversineDistance(delta_lat, delta_lng, cos_from, cos_to)
+            : EquirectangularDistance(delta_lat, delta_lng, cos_from, cos_to);
+    }
+
+    void ComputeSegmentDistances(const PointArrays& points, const uint32_t* ids, size_t count, double* distances,
+        DistanceMode mode) {
+        using namespace std;
+        if (count < 2) {
+            return;
+        }
+
+        const size_t segment_count = count - 1;
+
+        // Приближенные способы: один проход, совпадающие точки дают ноль без особой обработки
+        if (mode == DistanceMode::HAVERSINE) {
+            ComputeApproximateDistances<HaversineDistance>(points, ids, segment_count, distances);
+            return;
+        }
+        if (mode == DistanceMode::EQUIRECTANGULAR) {
+            ComputeApproximateDistances<EquirectangularDistance>(points, ids, segment_count, distances);
+            return;
+        }
+
+        // Косинус разности долгот
+        for (size_t i = 0; i < segment_count; ++i) {
+            distances[i] = cos(abs(points.lng[ids[i]] - points.lng[ids[i + 1]]) * dr);
+        }
+
+        // Косинус центрального угла
+        for (size_t i = 0; i < segment_count; ++i) {
+            const uint32_t from = ids[i];
+            const uint32_t to = ids[i + 1];
+            distances[i] = points.sin_lat[from] * points.sin_lat[to]
+                + points.cos_lat[from] * points.cos_lat[to] * distances[i];
+        }
+
+        // Расстояние по дуге. Для совпадающих точек - ноль, как в ComputeDistance
+        for (size_t i = 0; i < segment_count; ++i) {
+            const uint32_t from = ids[i];
+            const uint32_t to = ids[i + 1];
+            const bool same = points.lat[from] == points.lat[to] && points.lng[from] == points.lng[to];
+            distances[i] = same ? 0. : acos(distances[i]) * EARTH_RADUIS;
+        }
+    }
+
 }  // namespace geo
\ No newline at end of file
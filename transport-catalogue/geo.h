@@ -1,5 +1,10 @@
 ﻿#pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
 namespace geo {
 
     struct Coordinates {
@@ -15,4 +20,50 @@ namespace geo {
 
     double ComputeDistance(Coordinates from, Coordinates to);
 
+    // Способ расчета расстояния по поверхности Земли:
+    // SPHERICAL - сферическая теорема косинусов (как в ComputeDistance),
+    // HAVERSINE - формула гаверсинусов, устойчива для близких точек,
+    // EQUIRECTANGULAR - равнопромежуточная проекция, без тригонометрии на отрезок.
+    // Приближенные способы предназначены для коротких отрезков в пределах города
+    enum class DistanceMode {
+        SPHERICAL,
+        HAVERSINE,
+        EQUIRECTANGULAR
+    };
+
+    // Название способа расчета и обратное преобразование.
+    // Для неизвестного названия возвращается пустое значение
+    std::string_view GetDistanceModeName(DistanceMode mode);
+    std::optional<DistanceMode> ParseDistanceMode(std::string_view name);
+
+    double ComputeDistance(Coordinates from, Coordinates to, DistanceMode mode);
+
+    // Синус и косинус широты точки. Для остановок вычисляются один раз при загрузке
+    struct LatitudeTrig {
+        double sin_lat;
+        double cos_lat;
+    };
+
+    LatitudeTrig ComputeLatitudeTrig(double lat);
+
+    // Координаты точек в виде параллельных массивов с заранее вычисленной
+    // тригонометрией широты
+    struct PointArrays {
+        const double* lat = nullptr;
+        const double* lng = nullptr;
+        const double* sin_lat = nullptr;
+        const double* cos_lat = nullptr;
+    };
+
+    // Пакетный расчет расстояний между соседними точками цепочки: distances[i] - расстояние
+    // от точки ids[i] до точки ids[i + 1], всего count - 1 значений.
+    // Формула и порядок операций те же, что в ComputeDistance, поэтому результаты
+    // совпадают с ней бит в бит при одинаковых настройках компилятора (расхождение возможно
+    // только при слиянии умножения и сложения в FMA и не превышает 1e-9 относительной величины).
+    // Расчет разбит на проходы по непрерывным массивам без ветвлений, которые компилятор
+    // может векторизовать; тригонометрические функции берутся из стандартной библиотеки.
+    // Для приближенных способов результат совпадает с ComputeDistance(from, to, mode)
+    void ComputeSegmentDistances(const PointArrays& points, const uint32_t* ids, size_t count, double* distances,
+        DistanceMode mode = DistanceMode::SPHERICAL);
+
 }  // namespace geo
\ No newline at end of file
@@ -1,7 +1,9 @@
 ﻿#pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -42,6 +44,10 @@ public:
     // Добавление ребра в граф. Возвращает присвоенное значение id ребра в графе
     EdgeId AddEdge(const Edge<Weight>& edge);
 
+    // Исключение ребра из списка исходящих ребер его начальной вершины. Ребро остается
+    // в массиве ребер, поэтому id остальных ребер не меняются
+    void RemoveEdge(EdgeId edge_id);
+
     // Возврат количества вершин графа
     size_t GetVertexCount() const;
 
@@ -54,6 +60,10 @@ public:
     // Возвращает пару итераторов на массив ребер, исходящих из id узла vertex
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Расход памяти на ребра и списки исходящих ребер
+    memory_usage::Usage GetEdgesMemoryUsage() const;
+    memory_usage::Usage GetIncidenceMemoryUsage() const;
+
 private:
     // Массив всех ребер
     std::vector<Edge<Weight>> edges_;
@@ -78,6 +88,17 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    IncidenceList& incidence_list = incidence_lists_.at(GetEdge(edge_id).from);
+
+    // Повторное исключение ребра ничего не меняет
+    auto it = std::find(incidence_list.begin(), incidence_list.end(), edge_id);
+    if (it != incidence_list.end()) {
+        incidence_list.erase(it);
+    }
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -98,4 +119,18 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+memory_usage::Usage DirectedWeightedGraph<Weight>::GetEdgesMemoryUsage() const {
+    return memory_usage::Of(edges_);
+}
+
+template <typename Weight>
+memory_usage::Usage DirectedWeightedGraph<Weight>::GetIncidenceMemoryUsage() const {
+    memory_usage::Usage result = memory_usage::Of(incidence_lists_);
+    for (const IncidenceList& incidence_list : incidence_lists_) {
+        result.bytes += memory_usage::Bytes(incidence_list);
+    }
+    return result;
+}
 }  // namespace graph
\ No newline at end of file
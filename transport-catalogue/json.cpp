@@ -1,242 +1,22 @@
 ﻿#include "json.h"
+#include "json_parser.h"
 
+#include <algorithm>
+#include <charconv>
 #include <iterator>
+#include <stdexcept>
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
-
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
-            }
-            return s;
-        }
-
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
-
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
-                }
-                result.push_back(LoadNode(input));
-            }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
-            }
-            return Node(std::move(result));
-        }
-
-        Node LoadDict(std::istream& input) {
-            Dict dict;
-
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
-                    }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
-                    }
-                }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
-                }
-            }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
-            }
-            return Node(std::move(dict));
-        }
-
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    throw ParsingError("String parsing error");
-                }
-                const char ch = *it;
-                if (ch == '"') {
-                    ++it;
-                    break;
-                }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
-                        throw ParsingError("String parsing error");
-                    }
-                    const char escaped_char = *(it);
-                    switch (escaped_char) {
-                    case 'n':
-                        s.push_back('\n');
-                        break;
-                    case 't':
-                        s.push_back('\t');
-                        break;
-                    case 'r':
-                        s.push_back('\r');
-                        break;
-                    case '"':
-                        s.push_back('"');
-                        break;
-                    case '\\':
-                        s.push_back('\\');
-                        break;
-                    default:
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-                    }
-                }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
-                }
-                else {
-                    s.push_back(ch);
-                }
-                ++it;
-            }
-
-            return Node(std::move(s));
-        }
-
-        Node LoadBool(std::istream& input) {
-            const auto s = LoadLiteral(input);
-            if (s == "true"sv) {
-                return Node{ true };
-            }
-            else if (s == "false"sv) {
-                return Node{ false };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
-            }
-        }
-
-        Node LoadNull(std::istream& input) {
-            if (auto literal = LoadLiteral(input); literal == "null"sv) {
-                return Node{ nullptr };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
-            }
-        }
-
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
-
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
-
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
-                }
-                while (std::isdigit(input.peek())) {
-                    read_char();
-                }
-            };
-
-            if (input.peek() == '-') {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
-            }
-            else {
-                read_digits();
-            }
-
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
-
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
-                }
-                read_digits();
-                is_int = false;
-            }
-
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
-                    }
-                }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-            }
-        }
-
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-                // подсказкой компилятору и человеку, что здесь программист явно задумывал
-                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-                // написать break, return или throw.
-                // В данном случае, встретив t или f, переходим к попытке парсинга
-                // литералов true либо false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
-            }
-        }
-
         struct PrintContext {
             std::ostream& out;
             int indent_step = 4;
             int indent = 0;
+            // Вывод в одну строку: без переносов, отступов и пробелов после ':'
+            bool compact = false;
 
             void PrintIndent() const {
                 for (int i = 0; i < indent; ++i) {
@@ -244,8 +24,14 @@ namespace json {
                 }
             }
 
+            void PrintLineBreak() const {
+                if (!compact) {
+                    out.put('\n');
+                }
+            }
+
             PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
+                return { out, indent_step, indent_step + indent, compact };
             }
         };
 
@@ -256,35 +42,113 @@ namespace json {
             ctx.out << value;
         }
 
-        void PrintString(const std::string& value, std::ostream& out) {
+        // Числа преобразуются в текст через std::to_chars, без форматирования потоком.
+        // int выводится так же, как оператором <<
+        template <>
+        void PrintValue<int>(const int& value, const PrintContext& ctx) {
+            char buffer[16];
+            const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+            ctx.out.write(buffer, result.ptr - buffer);
+        }
+
+        // double выводится в общем формате с точностью потока, как оператором <<
+        // при флагах по умолчанию (printf "%.6g" при точности 6). Если число не помещается
+        // в буфер при большой заданной точности, используется вывод потоком
+        template <>
+        void PrintValue<double>(const double& value, const PrintContext& ctx) {
+            char buffer[32];
+            const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value,
+                std::chars_format::general, static_cast<int>(ctx.out.precision()));
+            if (result.ec == std::errc{}) {
+                ctx.out.write(buffer, result.ptr - buffer);
+            }
+            else {
+                ctx.out << value;
+            }
+        }
+
+        // Участки строки без специальных символов выводятся одним блоком,
+        // экранируются только найденные специальные символы
+        void PrintString(std::string_view value, std::ostream& out) {
             out.put('"');
-            for (const char c : value) {
-                switch (c) {
+            const char* current = value.data();
+            const char* const end = current + value.size();
+            while (true) {
+                const char* special = details::FindSpecialChar(current, end);
+                out.write(current, special - current);
+                if (special == end) {
+                    break;
+                }
+
+                switch (*special) {
                 case '\r':
                     out << "\\r"sv;
                     break;
                 case '\n':
                     out << "\\n"sv;
                     break;
-                case '"':
+                default:
                     // Символы " и \ выводятся как \" или \\, соответственно
-                    [[fallthrough]];
-                case '\\':
                     out.put('\\');
-                    [[fallthrough]];
-                default:
-                    out.put(c);
+                    out.put(*special);
                     break;
                 }
+                current = special + 1;
             }
             out.put('"');
         }
 
+        // Вывод текста JSON без пробельных символов вне строковых значений
+        void PrintCompactRaw(std::string_view text, std::ostream& out) {
+            bool in_string = false;
+            bool escaped = false;
+            for (const char c : text) {
+                if (in_string) {
+                    if (escaped) {
+                        escaped = false;
+                    }
+                    else if (c == '\\') {
+                        escaped = true;
+                    }
+                    else if (c == '"') {
+                        in_string = false;
+                    }
+                }
+                else if (c == '"') {
+                    in_string = true;
+                }
+                else if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                    continue;
+                }
+                out.put(c);
+            }
+        }
+
         template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+        void PrintValue<String>(const String& value, const PrintContext& ctx) {
             PrintString(value, ctx.out);
         }
 
+        template <>
+        void PrintValue<RawValue>(const RawValue& value, const PrintContext& ctx) {
+            if (ctx.compact) {
+                PrintCompactRaw(value.text, ctx.out);
+                return;
+            }
+
+            // Перенос строк внутри строковых значений JSON экранирован, поэтому
+            // каждый перенос в тексте относится к структуре документа.
+            // Пустые строки выводятся без отступа, как и при обычном выводе
+            bool line_start = false;
+            for (const char c : value.text) {
+                if (line_start && c != '\n') {
+                    ctx.PrintIndent();
+                }
+                ctx.out.put(c);
+                line_start = c == '\n';
+            }
+        }
+
         template <>
         void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
             ctx.out << "null"sv;
@@ -302,7 +166,8 @@ namespace json {
         template <>
         void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "[\n"sv;
+            out.put('[');
+            ctx.PrintLineBreak();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const Node& node : nodes) {
@@ -310,12 +175,13 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
+                    ctx.PrintLineBreak();
                 }
                 inner_ctx.PrintIndent();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintLineBreak();
             ctx.PrintIndent();
             out.put(']');
         }
@@ -323,7 +189,8 @@ namespace json {
         template <>
         void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "{\n"sv;
+            out.put('{');
+            ctx.PrintLineBreak();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const auto& [key, node] : nodes) {
@@ -331,14 +198,15 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
+                    ctx.PrintLineBreak();
                 }
                 inner_ctx.PrintIndent();
                 PrintString(key, ctx.out);
-                out << ": "sv;
+                out << (ctx.compact ? ":"sv : ": "sv);
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintLineBreak();
             ctx.PrintIndent();
             out.put('}');
         }
@@ -359,6 +227,9 @@ namespace json {
     Node::Node(Value value)
         :Value(std::move(value)) {}
 
+    Node::Node(const std::string& value)
+        :Value(String(value)) {}
+
     bool Node::IsInt() const {
         return std::holds_alternative<int>(*this);
     }
@@ -413,15 +284,15 @@ namespace json {
     }
 
     bool Node::IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<String>(*this);
     }
-    const std::string& Node::AsString() const {
+    std::string_view Node::AsString() const {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
         }
 
-        return std::get<std::string>(*this);
+        return std::get<String>(*this);
     }
 
     bool Node::IsDict() const {
@@ -447,12 +318,250 @@ namespace json {
     // ---------- Конец класса Node
 
 
+    // --------- Методы класса Dict ----------
+
+    namespace {
+
+        bool KeyLess(const Dict::value_type& item, std::string_view key) {
+            return std::string_view(item.first) < key;
+        }
+
+        bool ItemLess(const Dict::value_type& lhs, const Dict::value_type& rhs) {
+            return lhs.first < rhs.first;
+        }
+
+    }  // namespace
+
+    Dict::Dict(const allocator_type& allocator)
+        : items_(allocator) {
+    }
+
+    Dict::Dict(std::initializer_list<std::pair<std::string_view, Node>> items) {
+        items_.reserve(items.size());
+        for (const auto& [key, value] : items) {
+            items_.emplace_back(String(key), value);
+        }
+        std::stable_sort(items_.begin(), items_.end(), ItemLess);
+    }
+
+    Dict::Dict(Items items)
+        : items_(std::move(items)) {
+        if (!std::is_sorted(items_.begin(), items_.end(), ItemLess)) {
+            std::stable_sort(items_.begin(), items_.end(), ItemLess);
+        }
+    }
+
+    Dict::const_iterator Dict::begin() const {
+        return items_.begin();
+    }
+
+    Dict::const_iterator Dict::end() const {
+        return items_.end();
+    }
+
+    size_t Dict::size() const {
+        return items_.size();
+    }
+
+    bool Dict::empty() const {
+        return items_.empty();
+    }
+
+    Dict::Items::const_iterator Dict::LowerBound(std::string_view key) const {
+        return std::lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    }
+
+    Dict::const_iterator Dict::find(std::string_view key) const {
+        auto it = LowerBound(key);
+        return it != items_.end() && it->first == key ? it : items_.end();
+    }
+
+    size_t Dict::count(std::string_view key) const {
+        return find(key) != items_.end() ? 1 : 0;
+    }
+
+    const Node& Dict::at(std::string_view key) const {
+        using namespace std::literals;
+
+        auto it = find(key);
+        if (it == items_.end()) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+        }
+        return it->second;
+    }
+
+    Node& Dict::operator[](std::string_view key) {
+        auto it = items_.begin() + (LowerBound(key) - items_.cbegin());
+        if (it == items_.end() || it->first != key) {
+            it = items_.emplace(it, key, nullptr);
+        }
+        return it->second;
+    }
+
+    bool Dict::emplace(std::string_view key, Node value) {
+        auto it = items_.begin() + (LowerBound(key) - items_.cbegin());
+        if (it != items_.end() && it->first == key) {
+            return false;
+        }
+        items_.emplace(it, key, std::move(value));
+        return true;
+    }
+
+    bool Dict::operator==(const Dict& rhs) const {
+        return items_ == rhs.items_;
+    }
+
+    // ---------- Конец класса Dict
+
+
+    // --------- Построение дерева узлов по событиям разбора ----------
+
+    DomBuilder::DomBuilder(std::pmr::memory_resource* resource)
+        : resource_(resource) {
+    }
+
+    void DomBuilder::Null() {
+        AddValue(nullptr);
+    }
+
+    void DomBuilder::Bool(bool value) {
+        AddValue(value);
+    }
+
+    void DomBuilder::Int(int value) {
+        AddValue(value);
+    }
+
+    void DomBuilder::Double(double value) {
+        AddValue(value);
+    }
+
+    void DomBuilder::String(std::string_view value) {
+        AddValue(json::String(value, resource_));
+    }
+
+    void DomBuilder::Key(std::string_view key) {
+        stack_.back().key = json::String(key, resource_);
+    }
+
+    void DomBuilder::StartDict() {
+        stack_.push_back({ true, items_.size(), json::String(resource_) });
+    }
+
+    void DomBuilder::EndDict() {
+        using namespace std::literals;
+
+        const auto first = items_.begin() + stack_.back().begin;
+        stack_.pop_back();
+
+        Dict::Items items(resource_);
+        items.reserve(items_.end() - first);
+        items.insert(items.end(), std::make_move_iterator(first), std::make_move_iterator(items_.end()));
+        items_.erase(first, items_.end());
+
+        // Пары накапливаются в порядке документа и сортируются один раз
+        std::stable_sort(items.begin(), items.end(), ItemLess);
+        auto duplicate = std::adjacent_find(items.begin(), items.end(),
+            [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first == rhs.first;
+            });
+        if (duplicate != items.end()) {
+            throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
+        }
+
+        AddValue(Dict(std::move(items)));
+    }
+
+    void DomBuilder::StartArray() {
+        stack_.push_back({ false, values_.size(), json::String(resource_) });
+    }
+
+    void DomBuilder::EndArray() {
+        const auto first = values_.begin() + stack_.back().begin;
+        stack_.pop_back();
+
+        Array array(resource_);
+        array.reserve(values_.end() - first);
+        array.insert(array.end(), std::make_move_iterator(first), std::make_move_iterator(values_.end()));
+        values_.erase(first, values_.end());
+
+        AddValue(std::move(array));
+    }
+
+    Node DomBuilder::Extract() {
+        Node result = std::move(*root_);
+        root_.reset();
+        return result;
+    }
+
+    void DomBuilder::AddValue(Node value) {
+        if (stack_.empty()) {
+            root_ = std::move(value);
+        }
+        else if (!stack_.back().is_dict) {
+            values_.push_back(std::move(value));
+        }
+        else {
+            items_.emplace_back(std::move(stack_.back().key), std::move(value));
+        }
+    }
+
+    // ---------- Конец построения дерева узлов
+
+
+    namespace {
+
+        // Разбор документа с размещением всех узлов в арене документа
+        template <typename Source>
+        Document LoadDocument(Source& source) {
+            auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+            DomBuilder builder(arena.get());
+            Parse(source, builder);
+            return Document{ builder.Extract(), std::move(arena) };
+        }
+
+    }  // namespace
+
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        StreamSource source(input);
+        return LoadDocument(source);
+    }
+
+    Document Load(std::string_view text) {
+        BufferSource source(text);
+        return LoadDocument(source);
     }
 
     void Print(const Document& doc, std::ostream& output) {
         PrintNode(doc.GetRoot(), PrintContext{ output });
     }
 
+    void PrintCompact(const Node& node, std::ostream& output) {
+        PrintNode(node, PrintContext{ output, 0, 0, true });
+    }
+
+    // --------- Потоковый вывод массива ----------
+
+    ArrayWriter::ArrayWriter(std::ostream& output)
+        : output_(output) {
+        output_ << "[\n"sv;
+    }
+
+    void ArrayWriter::Write(const Node& node) {
+        if (first_) {
+            first_ = false;
+        }
+        else {
+            output_ << ",\n"sv;
+        }
+
+        const auto inner_ctx = PrintContext{ output_ }.Indented();
+        inner_ctx.PrintIndent();
+        PrintNode(node, inner_ctx);
+    }
+
+    void ArrayWriter::Finish() {
+        output_ << "\n]"sv;
+    }
+
 }  // namespace json
\ No newline at end of file
@@ -1,30 +1,93 @@
 ﻿#pragma once
 
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+
+    // Строки и массивы узлов используют полиморфный распределитель памяти: узлы
+    // разобранного документа размещаются в его арене, остальные - в общей куче
+    using String = std::pmr::string;
+    using Array = std::pmr::vector<Node>;
+
+    // Словарь в виде вектора пар, отсортированного по ключу. Поиск выполняется
+    // по string_view без создания временных строк, обход - по возрастанию ключа, как у std::map
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using Items = std::pmr::vector<value_type>;
+        using const_iterator = Items::const_iterator;
+        using allocator_type = Items::allocator_type;
+
+        Dict() = default;
+        explicit Dict(const allocator_type& allocator);
+        Dict(std::initializer_list<std::pair<std::string_view, Node>> items);
+
+        // Словарь из пар в произвольном порядке. Ключи должны быть различны
+        explicit Dict(Items items);
+
+        const_iterator begin() const;
+        const_iterator end() const;
+        size_t size() const;
+        bool empty() const;
+
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+
+        // Значение по ключу. Если ключа нет, выбрасывает std::out_of_range
+        const Node& at(std::string_view key) const;
+
+        // Значение по ключу. Если ключа нет, добавляется пустой узел
+        Node& operator[](std::string_view key);
+
+        // Добавление пары, если ключа еще нет. Возвращает признак добавления
+        bool emplace(std::string_view key, Node value);
+
+        bool operator==(const Dict& rhs) const;
+
+    private:
+        Items items_;
+
+        // Позиция первого ключа, не меньшего key
+        Items::const_iterator LowerBound(std::string_view key) const;
+    };
 
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
     };
 
+    // Заранее сформированный текст JSON, который выводится без изменений.
+    // Текст должен быть отформатирован как корневой узел документа: при выводе
+    // внутри массива или словаря к каждой его строке добавляется текущий отступ
+    struct RawValue {
+        std::string text;
+
+        bool operator==(const RawValue& rhs) const {
+            return text == rhs.text;
+        }
+    };
+
     class Node final
-        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String, RawValue> {
     public:
         using variant::variant;
         using Value = variant;
 
         Node(Value value);
 
+        // Строка из общей кучи
+        Node(const std::string& value);
+
         bool IsInt() const;
         int AsInt() const;
 
@@ -41,7 +104,7 @@ namespace json {
         const Array& AsArray() const;
 
         bool IsString() const;
-        const std::string& AsString() const;
+        std::string_view AsString() const;
 
         bool IsDict() const;
         const Dict& AsDict() const;
@@ -61,11 +124,20 @@ namespace json {
             : root_(std::move(root)) {
         }
 
+        // Документ, узлы которого размещены в арене arena. Арена освобождается
+        // целиком вместе с документом
+        Document(Node root, std::unique_ptr<std::pmr::memory_resource> arena)
+            : arena_(std::move(arena))
+            , root_(std::move(root)) {
+        }
+
         const Node& GetRoot() const {
             return root_;
         }
 
     private:
+        // Объявлена перед корнем, чтобы разрушаться после узлов
+        std::unique_ptr<std::pmr::memory_resource> arena_;
         Node root_;
     };
 
@@ -79,6 +151,31 @@ namespace json {
 
     Document Load(std::istream& input);
 
+    // Разбор документа из непрерывного буфера. Символы после документа не проверяются
+    Document Load(std::string_view text);
+
     void Print(const Document& doc, std::ostream& output);
 
+    // Вывод узла в одну строку, без переносов и отступов, например для формата JSON Lines
+    void PrintCompact(const Node& node, std::ostream& output);
+
+    // Потоковый вывод массива верхнего уровня. Каждый элемент выводится сразу
+    // при добавлении, результат совпадает с выводом Print для документа с этим массивом
+    class ArrayWriter {
+    public:
+        explicit ArrayWriter(std::ostream& output);
+
+        ArrayWriter(const ArrayWriter&) = delete;
+        ArrayWriter& operator=(const ArrayWriter&) = delete;
+
+        void Write(const Node& node);
+
+        // Вывод закрывающей скобки. После него элементы добавлять нельзя
+        void Finish();
+
+    private:
+        std::ostream& output_;
+        bool first_ = true;
+    };
+
 }  // namespace json
\ No newline at end of file
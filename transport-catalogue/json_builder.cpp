@@ -51,9 +51,9 @@ namespace json {
 	// элемент массива или, если вызвать сразу после конструктора json::Builder,
 	// всё содержимое конструируемого JSON - объекта.Может принимать как простой
 	// объект — число или строку — так и целый массив или словарь.
-	// Здесь Node::Value — это синоним для базового класса Node, шаблона variant
-	// с набором возможных типов - значений.Смотрите заготовку кода.
-	AfterNoLim Builder::Value(Node::Value value) {
+	// Значение передается узлом: кроме вариантов Node::Value, узел можно
+	// построить из std::string.
+	AfterNoLim Builder::Value(Node value) {
 
 		// Проверка, что объект готов: задан root_ и массив создания пуст
 		if (ObjectIsFinished()) {
@@ -298,8 +298,8 @@ namespace json {
 		return builder_.Key(key);
 	}
 
-	AfterNoLim AfterNoLim::Value(Node::Value value) {
-		return builder_.Value(value);
+	AfterNoLim AfterNoLim::Value(Node value) {
+		return builder_.Value(std::move(value));
 	}
 
 	AfterStartDict AfterNoLim::StartDict() {
@@ -325,16 +325,16 @@ namespace json {
 
 	// Вспомогательные методы вспомогательных классов для обработки Value
 
-	AfterKeyValue AfterKey::Value(Node::Value value) {
-		return { builder_.Value(value) };
+	AfterKeyValue AfterKey::Value(Node value) {
+		return { builder_.Value(std::move(value)) };
 	}
 
-	AfterArrayValue AfterStartArray::Value(Node::Value value) {
-		return { builder_.Value(value) };
+	AfterArrayValue AfterStartArray::Value(Node value) {
+		return { builder_.Value(std::move(value)) };
 	}
 
-	AfterArrayValue AfterArrayValue::Value(Node::Value value) {
-		return { builder_.Value(value) };
+	AfterArrayValue AfterArrayValue::Value(Node value) {
+		return { builder_.Value(std::move(value)) };
 	}
 
 
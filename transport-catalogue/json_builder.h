@@ -21,7 +21,7 @@ namespace json {
 			: root_(nullptr) {}
 
 		AfterKey Key(std::string key);
-		AfterNoLim Value(Node::Value value);
+		AfterNoLim Value(Node value);
 		AfterStartDict StartDict();
 		AfterStartArray StartArray();
 		AfterNoLim EndDict();
@@ -67,7 +67,7 @@ namespace json {
 
 		AfterKey Key(std::string key);
 
-		AfterNoLim Value(Node::Value value);
+		AfterNoLim Value(Node value);
 
 		AfterStartDict StartDict();
 
@@ -89,7 +89,7 @@ namespace json {
 			: AfterNoLim(builder) {}
 
 		AfterKey Key(std::string key) = delete;
-		//AfterNoLim Value(Node::Value value) = delete;
+		//AfterNoLim Value(Node value) = delete;
 		//AfterStartDict StartDict() = delete;
 		//AfterStartArray StartArray() = delete;
 		AfterNoLim EndDict() = delete;
@@ -97,7 +97,7 @@ namespace json {
 		Node Build() = delete;
 
 		// Переход к правилу 2
-		AfterKeyValue Value(Node::Value value);
+		AfterKeyValue Value(Node value);
 	};
 
 	// 2. После вызова Value, последовавшего за вызовом Key, вызван Key или EndDict
@@ -108,7 +108,7 @@ namespace json {
 			: AfterNoLim(no_lim.builder_) {}
 
 		//AfterKey Key(std::string key) = delete;
-		AfterNoLim Value(Node::Value value) = delete;
+		AfterNoLim Value(Node value) = delete;
 		AfterStartDict StartDict() = delete;
 		AfterStartArray StartArray() = delete;
 		//AfterNoLim EndDict() = delete;
@@ -123,7 +123,7 @@ namespace json {
 			: AfterNoLim(builder) {}
 
 		//AfterKey Key(std::string key) = delete;
-		AfterNoLim Value(Node::Value value) = delete;
+		AfterNoLim Value(Node value) = delete;
 		AfterStartDict StartDict() = delete;
 		AfterStartArray StartArray() = delete;
 		//AfterNoLim EndDict() = delete;
@@ -138,7 +138,7 @@ namespace json {
 			: AfterNoLim(builder) {}
 
 		AfterKey Key(std::string key) = delete;
-		//AfterNoLim Value(Node::Value value) = delete;
+		//AfterNoLim Value(Node value) = delete;
 		//AfterStartDict StartDict() = delete;
 		//AfterStartArray StartArray() = delete;
 		AfterNoLim EndDict() = delete;
@@ -146,7 +146,7 @@ namespace json {
 		Node Build() = delete;
 
 		// Переход к правилу 5
-		AfterArrayValue Value(Node::Value value);
+		AfterArrayValue Value(Node value);
 	};
 
 	// 5. После вызова StartArray и серии Value следует Value, StartDict, StartArray или EndArray
@@ -156,7 +156,7 @@ namespace json {
 			: AfterNoLim(no_lim.builder_) {}
 
 		AfterKey Key(std::string key) = delete;
-		//AfterNoLim Value(Node::Value value) = delete;
+		//AfterNoLim Value(Node value) = delete;
 		//AfterStartDict StartDict() = delete;
 		//AfterStartArray StartArray() = delete;
 		AfterNoLim EndDict() = delete;
@@ -164,7 +164,7 @@ namespace json {
 		Node Build() = delete;
 
 		// Продолжение выполения правила 5
-		AfterArrayValue Value(Node::Value value);
+		AfterArrayValue Value(Node value);
 	};
 
 
@@ -0,0 +1,638 @@
+#pragma once
+
+#include "json.h"
+
+#include <cctype>
+#include <charconv>
+#include <istream>
+#include <memory_resource>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace json {
+
+    namespace details {
+
+        // Поиск в [first, last) первого символа, требующего особой обработки внутри строки JSON:
+        // кавычки, обратной косой черты или переноса строки. Если таких нет, возвращает last.
+        // При поддержке SSE2 проверяется по 16 символов за одно сравнение
+        inline const char* FindSpecialChar(const char* first, const char* last) {
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i line_feed = _mm_set1_epi8('\n');
+            const __m128i carriage_return = _mm_set1_epi8('\r');
+
+            for (; last - first >= 16; first += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const __m128i special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed), _mm_cmpeq_epi8(chunk, carriage_return)));
+                // Бит i маски установлен, если символ i блока специальный
+                if (const int mask = _mm_movemask_epi8(special); mask != 0) {
+                    return first + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+            }
+#endif
+            // Остаток буфера короче блока или SSE2 недоступен
+            for (; first != last; ++first) {
+                const char c = *first;
+                if (c == '"' || c == '\\' || c == '\n' || c == '\r') {
+                    break;
+                }
+            }
+            return first;
+        }
+
+        // Поиск в [first, last) первого символа, важного для структуры документа:
+        // кавычки, запятой или скобки массива или словаря. Если таких нет, возвращает last
+        inline const char* FindStructuralChar(const char* first, const char* last) {
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i open_bracket = _mm_set1_epi8('[');
+            const __m128i close_bracket = _mm_set1_epi8(']');
+            const __m128i open_brace = _mm_set1_epi8('{');
+            const __m128i close_brace = _mm_set1_epi8('}');
+
+            for (; last - first >= 16; first += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const __m128i structural = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, comma)),
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, open_bracket), _mm_cmpeq_epi8(chunk, close_bracket))),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, open_brace), _mm_cmpeq_epi8(chunk, close_brace)));
+                if (const int mask = _mm_movemask_epi8(structural); mask != 0) {
+                    return first + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+            }
+#endif
+            for (; first != last; ++first) {
+                const char c = *first;
+                if (c == '"' || c == ',' || c == '[' || c == ']' || c == '{' || c == '}') {
+                    break;
+                }
+            }
+            return first;
+        }
+
+    } // namespace details
+
+    // Источник символов для разбора JSON из потока ввода.
+    // Символы читаются напрямую из буфера потока, без проверок состояния потока на каждый символ
+    class StreamSource {
+    public:
+        static constexpr int END = std::char_traits<char>::eof();
+
+        explicit StreamSource(std::istream& input)
+            : buffer_(input.rdbuf()) {
+        }
+
+        // Текущий символ без извлечения. END в конце ввода
+        int Peek() {
+            return buffer_->sgetc();
+        }
+
+        // Извлечение текущего символа. END в конце ввода
+        int Get() {
+            return buffer_->sbumpc();
+        }
+
+        // Добавление в s символов строки до первого специального символа.
+        // Буфер потока недоступен напрямую, поэтому символы читаются по одному разборщиком
+        void AppendPlain(std::string&) {
+        }
+
+    private:
+        std::streambuf* buffer_;
+    };
+
+    // Источник символов для разбора JSON из непрерывного буфера, например
+    // из отображенного в память файла. Символы читаются перемещением указателя
+    class BufferSource {
+    public:
+        static constexpr int END = std::char_traits<char>::eof();
+
+        explicit BufferSource(std::string_view text)
+            : current_(text.data())
+            , end_(text.data() + text.size()) {
+        }
+
+        int Peek() const {
+            return current_ != end_ ? static_cast<unsigned char>(*current_) : END;
+        }
+
+        int Get() {
+            return current_ != end_ ? static_cast<unsigned char>(*current_++) : END;
+        }
+
+        // Добавление в s символов строки до первого специального символа
+        // (кавычки, обратной косой черты или переноса строки) одним блоком
+        void AppendPlain(std::string& s) {
+            const char* plain_end = details::FindSpecialChar(current_, end_);
+            s.append(current_, plain_end);
+            current_ = plain_end;
+        }
+
+        // Неразобранная часть буфера
+        std::string_view GetRest() const {
+            return { current_, static_cast<size_t>(end_ - current_) };
+        }
+
+        // Пропуск count символов без разбора
+        void Skip(size_t count) {
+            current_ += count;
+        }
+
+    private:
+        const char* current_;
+        const char* end_;
+    };
+
+    // Обработчик событий разбора, строящий дерево узлов. Строки, массивы и словари
+    // размещаются в ресурсе памяти resource, который должен жить дольше узлов
+    class DomBuilder {
+    public:
+        explicit DomBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        void Null();
+        void Bool(bool value);
+        void Int(int value);
+        void Double(double value);
+        void String(std::string_view value);
+        void Key(std::string_view key);
+        void StartDict();
+        void EndDict();
+        void StartArray();
+        void EndArray();
+
+        // Построенный узел. Обработчик можно использовать для следующего значения
+        Node Extract();
+
+    private:
+        // Незавершенный массив или словарь. Элементы накапливаются в общих буферах
+        // values_ и items_ начиная с позиции begin и переносятся в арену одним блоком
+        // точного размера, когда контейнер завершен
+        struct Frame {
+            bool is_dict;
+            size_t begin;
+            // Ключ для следующего значения словаря
+            json::String key;
+        };
+
+        std::pmr::memory_resource* resource_;
+        std::vector<Frame> stack_;
+        std::vector<Node> values_;
+        std::vector<Dict::value_type> items_;
+        std::optional<Node> root_;
+
+        void AddValue(Node value);
+    };
+
+    namespace details {
+
+        // Разбор одного значения из источника с передачей событий обработчику
+        template <typename Source, typename Handler>
+        class Parser {
+        public:
+            Parser(Source& source, Handler& handler)
+                : source_(source)
+                , handler_(handler) {
+            }
+
+            void ParseValue() {
+                using namespace std::literals;
+
+                SkipSpaces();
+                const int c = source_.Get();
+                switch (c) {
+                case Source::END:
+                    throw ParsingError("Unexpected EOF"s);
+                case '[':
+                    ParseArray();
+                    break;
+                case '{':
+                    ParseDict();
+                    break;
+                case '"':
+                    handler_.String(ParseString());
+                    break;
+                case 't':
+                    [[fallthrough]];
+                case 'f':
+                    ParseBool(static_cast<char>(c));
+                    break;
+                case 'n':
+                    ParseNull();
+                    break;
+                default:
+                    ParseNumber(static_cast<char>(c));
+                    break;
+                }
+            }
+
+            // Разбор словаря, значения которого разбирает parse_entry(key).
+            // Ключ ссылается на буфер разборщика и действителен до разбора следующей строки
+            template <typename EntryParser>
+            void ParseDictEntries(EntryParser parse_entry) {
+                using namespace std::literals;
+
+                if (GetSignificant() != '{') {
+                    throw ParsingError("Dictionary parsing error"s);
+                }
+                ParseEntries(parse_entry);
+            }
+
+        private:
+            Source& source_;
+            Handler& handler_;
+
+            // Буферы для литералов и чисел и для строк, переиспользуются между значениями
+            std::string buffer_;
+            std::string string_buffer_;
+
+            void SkipSpaces() {
+                while (source_.Peek() != Source::END && std::isspace(source_.Peek())) {
+                    source_.Get();
+                }
+            }
+
+            // Следующий значащий символ с извлечением. END в конце ввода
+            int GetSignificant() {
+                SkipSpaces();
+                return source_.Get();
+            }
+
+            void ParseArray() {
+                using namespace std::literals;
+
+                handler_.StartArray();
+
+                SkipSpaces();
+                if (source_.Peek() == ']') {
+                    source_.Get();
+                    handler_.EndArray();
+                    return;
+                }
+
+                while (true) {
+                    ParseValue();
+
+                    const int c = GetSignificant();
+                    if (c == ']') {
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError("Array parsing error"s);
+                    }
+                }
+
+                handler_.EndArray();
+            }
+
+            void ParseDict() {
+                handler_.StartDict();
+                ParseEntries([this](std::string_view key) {
+                    handler_.Key(key);
+                    ParseValue();
+                });
+                handler_.EndDict();
+            }
+
+            // Разбор пар словаря после открывающей скобки
+            template <typename EntryParser>
+            void ParseEntries(EntryParser&& parse_entry) {
+                using namespace std::literals;
+
+                int c = GetSignificant();
+                if (c == '}') {
+                    return;
+                }
+
+                while (true) {
+                    if (c != '"') {
+                        if (c == Source::END) {
+                            throw ParsingError("Dictionary parsing error"s);
+                        }
+                        throw ParsingError(R"(',' is expected but ')"s + static_cast<char>(c) + "' has been found"s);
+                    }
+                    const std::string_view key = ParseString();
+
+                    if (c = GetSignificant(); c != ':') {
+                        throw ParsingError(": is expected but '"s + static_cast<char>(c) + "' has been found"s);
+                    }
+                    parse_entry(key);
+
+                    c = GetSignificant();
+                    if (c == '}') {
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError("Dictionary parsing error"s);
+                    }
+                    c = GetSignificant();
+                }
+            }
+
+            // Разбор строки после открывающей кавычки. Результат ссылается на буфер
+            // разборщика и действителен до разбора следующей строки
+            std::string_view ParseString() {
+                using namespace std::literals;
+
+                std::string& s = string_buffer_;
+                s.clear();
+                while (true) {
+                    source_.AppendPlain(s);
+
+                    const int ch = source_.Get();
+                    if (ch == Source::END) {
+                        throw ParsingError("String parsing error");
+                    }
+                    if (ch == '"') {
+                        break;
+                    }
+                    else if (ch == '\\') {
+                        const int escaped_char = source_.Get();
+                        switch (escaped_char) {
+                        case Source::END:
+                            throw ParsingError("String parsing error");
+                        case 'n':
+                            s.push_back('\n');
+                            break;
+                        case 't':
+                            s.push_back('\t');
+                            break;
+                        case 'r':
+                            s.push_back('\r');
+                            break;
+                        case '"':
+                            s.push_back('"');
+                            break;
+                        case '\\':
+                            s.push_back('\\');
+                            break;
+                        default:
+                            throw ParsingError("Unrecognized escape sequence \\"s + static_cast<char>(escaped_char));
+                        }
+                    }
+                    else if (ch == '\n' || ch == '\r') {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    else {
+                        s.push_back(static_cast<char>(ch));
+                    }
+                }
+                return s;
+            }
+
+            // Чтение литерала, первый символ которого уже извлечен
+            const std::string& ReadLiteral(char first) {
+                buffer_.assign(1, first);
+                while (source_.Peek() != Source::END && std::isalpha(source_.Peek())) {
+                    buffer_.push_back(static_cast<char>(source_.Get()));
+                }
+                return buffer_;
+            }
+
+            void ParseBool(char first) {
+                using namespace std::literals;
+
+                const std::string& s = ReadLiteral(first);
+                if (s == "true"sv) {
+                    handler_.Bool(true);
+                }
+                else if (s == "false"sv) {
+                    handler_.Bool(false);
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+                }
+            }
+
+            void ParseNull() {
+                using namespace std::literals;
+
+                if (const std::string& literal = ReadLiteral('n'); literal == "null"sv) {
+                    handler_.Null();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+                }
+            }
+
+            // Разбор числа, первый символ которого уже извлечен
+            void ParseNumber(char first) {
+                using namespace std::literals;
+
+                std::string& parsed_num = buffer_;
+                parsed_num.clear();
+
+                // Считывает в parsed_num очередной символ
+                auto read_char = [this, &parsed_num] {
+                    const int ch = source_.Get();
+                    if (ch == Source::END) {
+                        throw ParsingError("Failed to read number from stream"s);
+                    }
+                    parsed_num += static_cast<char>(ch);
+                };
+
+                auto is_digit = [](int ch) {
+                    return ch != Source::END && std::isdigit(ch);
+                };
+
+                // Считывает одну или более цифр в parsed_num
+                auto read_digits = [this, &is_digit, &read_char] {
+                    if (!is_digit(source_.Peek())) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (is_digit(source_.Peek())) {
+                        read_char();
+                    }
+                };
+
+                // Первый символ - знак или первая цифра целой части
+                if (first == '-') {
+                    parsed_num += first;
+                    if (source_.Peek() == '0') {
+                        read_char();
+                    }
+                    else {
+                        read_digits();
+                    }
+                }
+                else if (first == '0') {
+                    parsed_num += first;
+                    // После 0 в JSON не могут идти другие цифры
+                }
+                else if (is_digit(static_cast<unsigned char>(first))) {
+                    parsed_num += first;
+                    while (is_digit(source_.Peek())) {
+                        read_char();
+                    }
+                }
+                else {
+                    throw ParsingError("A digit is expected"s);
+                }
+
+                bool is_int = true;
+                // Парсим дробную часть числа
+                if (source_.Peek() == '.') {
+                    read_char();
+                    read_digits();
+                    is_int = false;
+                }
+
+                // Парсим экспоненциальную часть числа
+                if (int ch = source_.Peek(); ch == 'e' || ch == 'E') {
+                    read_char();
+                    if (ch = source_.Peek(); ch == '+' || ch == '-') {
+                        read_char();
+                    }
+                    read_digits();
+                    is_int = false;
+                }
+
+                // Строка уже проверена по грамматике JSON, поэтому преобразование
+                // std::from_chars может завершиться ошибкой только при переполнении
+                const char* first_char = parsed_num.data();
+                const char* last_char = first_char + parsed_num.size();
+
+                if (is_int) {
+                    // Сначала пробуем преобразовать строку в int. При переполнении
+                    // строка преобразуется в double
+                    int value;
+                    if (const auto result = std::from_chars(first_char, last_char, value); result.ec == std::errc{}) {
+                        handler_.Int(value);
+                        return;
+                    }
+                }
+
+                double value;
+                if (const auto result = std::from_chars(first_char, last_char, value);
+                    result.ec != std::errc{} || result.ptr != last_char) {
+                    throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+                }
+                handler_.Double(value);
+            }
+        };
+
+    } // namespace details
+
+    // Потоковый разбор одного значения JSON. Вместо построения узлов для каждого элемента
+    // вызывается метод обработчика: Null(), Bool(bool), Int(int), Double(double),
+    // String(std::string_view), Key(std::string_view), StartDict(), EndDict(), StartArray(), EndArray().
+    // Строки передаются из буфера разборщика и действительны только во время вызова.
+    // Источник предоставляет методы Peek(), Get(), AppendPlain() и константу END,
+    // как StreamSource и BufferSource.
+    // Символы после значения остаются в источнике
+    template <typename Source, typename Handler>
+    void Parse(Source& source, Handler& handler) {
+        details::Parser<Source, Handler>(source, handler).ParseValue();
+    }
+
+    namespace details {
+
+        // Обработчик без методов для разбора, в котором события не передаются
+        struct NoEvents {
+        };
+
+    } // namespace details
+
+    // Разбор словаря, значения которого разбираются вызывающим: для каждой пары вызывается
+    // parse_entry(std::string_view key), который должен извлечь из источника одно значение,
+    // например вызовом Parse. Ключ действителен только во время вызова
+    template <typename Source, typename EntryParser>
+    void ParseDictEntries(Source& source, EntryParser parse_entry) {
+        details::NoEvents no_events;
+        details::Parser<Source, details::NoEvents>(source, no_events).ParseDictEntries(parse_entry);
+    }
+
+    // Структурный просмотр массива: границы элементов верхнего уровня определяются только
+    // по скобкам и строкам, без разбора значений, и источник переходит за массив.
+    // Части текста с элементами не проверяются и должны быть разобраны отдельно,
+    // например параллельно. Пробельные символы вокруг элементов сохраняются
+    inline std::vector<std::string_view> SplitArray(BufferSource& source) {
+        using namespace std::literals;
+
+        const std::string_view text = source.GetRest();
+        const char* current = text.data();
+        const char* const end = current + text.size();
+
+        while (current != end && std::isspace(static_cast<unsigned char>(*current))) {
+            ++current;
+        }
+        if (current == end || *current != '[') {
+            throw ParsingError("Array parsing error"s);
+        }
+        ++current;
+
+        std::vector<std::string_view> result;
+        const char* element_begin = current;
+        // Глубина вложенности внутри текущего элемента
+        int depth = 0;
+
+        auto add_element = [&](const char* element_end) {
+            result.emplace_back(element_begin, static_cast<size_t>(element_end - element_begin));
+            element_begin = element_end + 1;
+        };
+
+        for (current = details::FindStructuralChar(current, end); current != end;
+            current = details::FindStructuralChar(current + 1, end)) {
+            switch (*current) {
+            case '"':
+                // Пропуск строки с экранированными символами
+                for (current = details::FindSpecialChar(current + 1, end);
+                    current != end && *current != '"';
+                    current = details::FindSpecialChar(current, end)) {
+                    current += *current == '\\' ? 2 : 1;
+                    if (current > end) {
+                        current = end;
+                    }
+                }
+                if (current == end) {
+                    throw ParsingError("String parsing error"s);
+                }
+                break;
+            case '[':
+                [[fallthrough]];
+            case '{':
+                ++depth;
+                break;
+            case ']':
+                if (depth == 0) {
+                    // Пустой массив не содержит элементов. Пустой элемент после запятой
+                    // остается в результате, и его разбор завершится ошибкой
+                    const std::string_view last(element_begin, static_cast<size_t>(current - element_begin));
+                    if (!result.empty() || last.find_first_not_of(" \t\r\n"sv) != std::string_view::npos) {
+                        add_element(current);
+                    }
+                    source.Skip(static_cast<size_t>(current + 1 - text.data()));
+                    return result;
+                }
+                --depth;
+                break;
+            case '}':
+                --depth;
+                break;
+            case ',':
+                if (depth == 0) {
+                    add_element(current);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        throw ParsingError("Array parsing error"s);
+    }
+
+}  // namespace json
@@ -1,9 +1,17 @@
 ﻿#include "json_reader.h"
 #include "json_builder.h"
+#include "json_parser.h"
+#include "parallel.h"
 
+#include <algorithm>
 #include <exception>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <optional>
 #include <string_view>
 #include <deque>
+#include <unordered_set>
 #include <vector>
 #include <sstream>
 
@@ -18,7 +26,7 @@ namespace details {
 svg::Color ParseColor(const json::Node& color_ptr) {
 	if (color_ptr.IsString()) {
 		// Если цвет задан строкой, то присваивает строку
-		return color_ptr.AsString();
+		return string(color_ptr.AsString());
 	}
 	else {
 		auto& color_code = color_ptr.AsArray();
@@ -42,56 +50,483 @@ svg::Color ParseColor(const json::Node& color_ptr) {
 	}
 }
 
-deque<transport_catalogue::StopToAdd> GetStopsList(const json::Array& requests) {
-	using namespace transport_catalogue;
+transport_catalogue::RequestInfo GetRequest(const json::Node& request_json);
+
+// Обработчик событий разбора входного документа. Запросы base_requests заполняют
+// списки остановок и маршрутов сразу при разборе, без построения узлов JSON.
+// Каждый запрос stat_requests собирается в узлы во временном буфере и сразу
+// разбирается в структуру своего типа.
+// Остальные разделы документа небольшие, они собираются в узлы в ресурсе памяти resource
+// и сохраняются в sections
+class InputHandler {
+public:
+	InputHandler(InputQueries& result, json::Dict& sections, std::pmr::memory_resource* resource)
+		: result_(result)
+		, sections_(sections)
+		, section_builder_(resource)
+		, request_arena_(request_buffer_, sizeof(request_buffer_))
+		, request_builder_(&request_arena_) {
+	}
+
+	void Null() {
+		Value(nullptr);
+	}
 
-	deque<StopToAdd> result;
+	void Bool(bool value) {
+		Value(value);
+	}
 
-	for (auto& request : requests) {
-		if (request.AsDict().at("type"s).AsString() == "Stop"s) {
-			StopToAdd stop;
+	void Int(int value) {
+		Value(value);
+	}
 
-			stop.name = request.AsDict().at("name"s).AsString();
-			stop.location.lat = request.AsDict().at("latitude"s).AsDouble();
-			stop.location.lng = request.AsDict().at("longitude"s).AsDouble();
+	void Double(double value) {
+		Value(value);
+	}
 
-			const json::Dict& stops_distances = request.AsDict().at("road_distances"s).AsDict();
+	void String(string_view value) {
+		Value(value);
+	}
 
-			for (const auto& [stop_name, distance] : stops_distances) {
-				stop.distances_to_stops.emplace_back(stop_name, distance.AsInt());
+	void Key(string_view key) {
+		if (depth_ == 1) {
+			// Начало раздела документа
+			CheckSectionKey(key);
+			section_key_ = key;
+			section_ = section_key_ == "base_requests"sv ? Section::BASE_REQUESTS
+				: section_key_ == "stat_requests"sv ? Section::STAT_REQUESTS
+				: Section::OTHER;
+		}
+		else if (section_ == Section::OTHER) {
+			section_builder_.Key(key);
+		}
+		else if (section_ == Section::STAT_REQUESTS) {
+			request_builder_.Key(key);
+		}
+		else if (depth_ == 3) {
+			field_ = key;
+			MarkField();
+		}
+		else {
+			// Ключ вложенного словаря: расстояний до остановок или неизвестного поля
+			if (!nested_keys_[nested_depth_ - 1].emplace(key).second) {
+				throw json::ParsingError("Duplicate key '"s + string(key) + "' have been found");
+			}
+			if (depth_ == 4 && field_ == "road_distances"sv) {
+				distance_stop_ = key;
 			}
+		}
+	}
 
-			result.push_back(move(stop));
+	// Раздел документа может встретиться только один раз
+	void CheckSectionKey(string_view key) {
+		if (!section_keys_.emplace(key).second) {
+			throw json::ParsingError("Duplicate key '"s + string(key) + "' have been found");
 		}
 	}
 
-	return result;
-}
+	void StartDict() {
+		Start(true);
+	}
 
-deque<transport_catalogue::BusToAdd> GetBusesList(const json::Array& requests) {
-	using namespace transport_catalogue;
+	void EndDict() {
+		End(true);
+	}
+
+	void StartArray() {
+		Start(false);
+	}
+
+	void EndArray() {
+		End(false);
+	}
+
+private:
+	// Раздел документа, значение которого сейчас разбирается
+	enum class Section {
+		NONE,
+		BASE_REQUESTS,
+		STAT_REQUESTS,
+		OTHER
+	};
+
+	// Поля запроса base_requests, заданные в документе. UNKNOWN - поле с неизвестным названием
+	enum Field : unsigned {
+		UNKNOWN = 0,
+		NAME = 1,
+		LATITUDE = 2,
+		LONGITUDE = 4,
+		ROAD_DISTANCES = 8,
+		IS_ROUNDTRIP = 16,
+		STOPS = 32,
+		TYPE = 64
+	};
+
+	InputQueries& result_;
+	json::Dict& sections_;
+
+	// Глубина вложенности: 1 - корневой словарь, 2 - значение раздела,
+	// 3 - поля запроса base_requests, 4 - элементы road_distances и stops
+	int depth_ = 0;
+	Section section_ = Section::NONE;
+	string section_key_;
+	unordered_set<string> section_keys_;
+	json::DomBuilder section_builder_;
+
+	// Узлы разбираемого запроса stat_requests. Буфер переиспользуется для каждого запроса
+	alignas(std::max_align_t) char request_buffer_[4096];
+	std::pmr::monotonic_buffer_resource request_arena_;
+	json::DomBuilder request_builder_;
+
+	// Разбираемый запрос base_requests. Тип запроса может идти после остальных полей,
+	// поэтому заполняются обе структуры, а в результат попадает одна из них
+	string type_;
+	string name_;
+	string field_;
+	string distance_stop_;
+	unsigned fields_ = 0;
+	// Поля запроса с неизвестными названиями и ключи вложенных словарей по уровням
+	// вложенности. Повторный ключ - ошибка разбора, как и в остальных словарях документа.
+	// Наборы ключей вложенных словарей переиспользуются для следующих запросов
+	unordered_set<string> other_fields_;
+	vector<unordered_set<string>> nested_keys_;
+	size_t nested_depth_ = 0;
+	transport_catalogue::StopToAdd stop_;
+	transport_catalogue::BusToAdd bus_;
+
+	template <typename Scalar>
+	void Value(Scalar&& value) {
+		if (depth_ == 0) {
+			throw invalid_argument("Root isn't a Dict");
+		}
+
+		if (section_ == Section::OTHER) {
+			AddSectionValue(forward<Scalar>(value));
+			if (depth_ == 1) {
+				FinishSection();
+			}
+		}
+		else if (section_ == Section::BASE_REQUESTS) {
+			if (depth_ == 1) {
+				throw invalid_argument("base_requests must be an array"s);
+			}
+			if (depth_ == 2) {
+				throw invalid_argument("Base request must be a dict"s);
+			}
+			if (depth_ == 3) {
+				SetField(forward<Scalar>(value));
+			}
+			else if (depth_ == 4) {
+				AddListItem(forward<Scalar>(value));
+			}
+		}
+		else if (section_ == Section::STAT_REQUESTS) {
+			if (depth_ == 1) {
+				throw invalid_argument("stat_requests must be an array"s);
+			}
+			if (depth_ == 2) {
+				throw invalid_argument("Stat request must be a dict"s);
+			}
+			AddRequestValue(forward<Scalar>(value));
+		}
+	}
+
+	// Передача значения в построитель узлов раздела
+	void AddSectionValue(nullptr_t) {
+		section_builder_.Null();
+	}
+
+	void AddSectionValue(bool value) {
+		section_builder_.Bool(value);
+	}
+
+	void AddSectionValue(int value) {
+		section_builder_.Int(value);
+	}
 
-	deque<BusToAdd> result;
+	void AddSectionValue(double value) {
+		section_builder_.Double(value);
+	}
+
+	void AddSectionValue(string_view value) {
+		section_builder_.String(value);
+	}
+
+	// Передача значения в построитель узлов запроса stat_requests
+	void AddRequestValue(nullptr_t) {
+		request_builder_.Null();
+	}
 
-	for (auto& request : requests) {
-		if (request.AsDict().at("type"s).AsString() == "Bus"s) {
-			BusToAdd bus;
+	void AddRequestValue(bool value) {
+		request_builder_.Bool(value);
+	}
 
-			bus.name = request.AsDict().at("name"s).AsString();
-			bus.is_circle = request.AsDict().at("is_roundtrip"s).AsBool();
+	void AddRequestValue(int value) {
+		request_builder_.Int(value);
+	}
 
-			const json::Array& stops_list = request.AsDict().at("stops"s).AsArray();
+	void AddRequestValue(double value) {
+		request_builder_.Double(value);
+	}
 
-			for (auto& stop : stops_list) {
-				bus.stops.push_back(stop.AsString());
+	void AddRequestValue(string_view value) {
+		request_builder_.String(value);
+	}
+
+	void Start(bool is_dict) {
+		if (depth_ == 0 && !is_dict) {
+			throw invalid_argument("Root isn't a Dict");
+		}
+
+		if (section_ == Section::OTHER) {
+			if (is_dict) {
+				section_builder_.StartDict();
+			}
+			else {
+				section_builder_.StartArray();
+			}
+		}
+		else if (section_ == Section::BASE_REQUESTS) {
+			if (depth_ == 1 && is_dict) {
+				throw invalid_argument("base_requests must be an array"s);
+			}
+			if (depth_ == 2) {
+				if (!is_dict) {
+					throw invalid_argument("Base request must be a dict"s);
+				}
+				StartRequest();
+			}
+			else if (depth_ == 3) {
+				if ((field_ == "road_distances"sv && !is_dict) || (field_ == "stops"sv && is_dict)) {
+					throw invalid_argument("Unexpected value of base request field "s + field_);
+				}
+			}
+			else if (depth_ == 4 && (field_ == "road_distances"sv || field_ == "stops"sv)) {
+				throw invalid_argument("Unexpected value in base request field "s + field_);
 			}
 
-			result.push_back(move(bus));
+			if (depth_ >= 3 && is_dict) {
+				StartNestedDict();
+			}
 		}
+		else if (section_ == Section::STAT_REQUESTS) {
+			if (depth_ == 1 && is_dict) {
+				throw invalid_argument("stat_requests must be an array"s);
+			}
+			if (depth_ == 2 && !is_dict) {
+				throw invalid_argument("Stat request must be a dict"s);
+			}
+			if (depth_ >= 2) {
+				if (is_dict) {
+					request_builder_.StartDict();
+				}
+				else {
+					request_builder_.StartArray();
+				}
+			}
+		}
+
+		++depth_;
 	}
 
-	return result;
-}
+	void End(bool is_dict) {
+		--depth_;
+
+		if (section_ == Section::OTHER) {
+			if (is_dict) {
+				section_builder_.EndDict();
+			}
+			else {
+				section_builder_.EndArray();
+			}
+			if (depth_ == 1) {
+				FinishSection();
+			}
+		}
+		else if (section_ == Section::BASE_REQUESTS) {
+			if (depth_ >= 3 && is_dict) {
+				--nested_depth_;
+			}
+			if (depth_ == 2) {
+				FinishRequest();
+			}
+			else if (depth_ == 1) {
+				section_ = Section::NONE;
+			}
+		}
+		else if (section_ == Section::STAT_REQUESTS) {
+			if (depth_ >= 2) {
+				if (is_dict) {
+					request_builder_.EndDict();
+				}
+				else {
+					request_builder_.EndArray();
+				}
+			}
+			if (depth_ == 2) {
+				FinishStatRequest();
+			}
+			else if (depth_ == 1) {
+				section_ = Section::NONE;
+			}
+		}
+	}
+
+	void FinishStatRequest() {
+		{
+			const json::Node request_json = request_builder_.Extract();
+			result_.requests.push_back(GetRequest(request_json));
+		}
+		// Узлы запроса разрушены, буфер можно использовать для следующего запроса
+		request_arena_.release();
+	}
+
+	void FinishSection() {
+		sections_.emplace(move(section_key_), section_builder_.Extract());
+		section_ = Section::NONE;
+	}
+
+	void StartRequest() {
+		type_.clear();
+		name_.clear();
+		field_.clear();
+		fields_ = 0;
+		other_fields_.clear();
+		stop_ = {};
+		bus_ = {};
+	}
+
+	// Начало словаря внутри запроса base_requests
+	void StartNestedDict() {
+		if (nested_depth_ == nested_keys_.size()) {
+			nested_keys_.emplace_back();
+		}
+		else {
+			nested_keys_[nested_depth_].clear();
+		}
+		++nested_depth_;
+	}
+
+	// Отметка поля запроса. Поле может встретиться в запросе только один раз
+	void MarkField() {
+		const Field field = field_ == "type"sv ? TYPE
+			: field_ == "name"sv ? NAME
+			: field_ == "latitude"sv ? LATITUDE
+			: field_ == "longitude"sv ? LONGITUDE
+			: field_ == "road_distances"sv ? ROAD_DISTANCES
+			: field_ == "is_roundtrip"sv ? IS_ROUNDTRIP
+			: field_ == "stops"sv ? STOPS
+			: UNKNOWN;
+
+		const bool is_new = field != UNKNOWN ? (fields_ & field) == 0 : other_fields_.insert(field_).second;
+		if (!is_new) {
+			throw json::ParsingError("Duplicate key '"s + field_ + "' have been found");
+		}
+		fields_ |= field;
+	}
+
+	// Проверка, что в запросе заданы все поля из набора required
+	void CheckFields(unsigned required) const {
+		if ((fields_ & required) != required) {
+			throw invalid_argument("Base request "s + type_ + " has missing fields"s);
+		}
+	}
+
+	void FinishRequest() {
+		if (type_ == "Stop"sv) {
+			CheckFields(NAME | LATITUDE | LONGITUDE | ROAD_DISTANCES);
+			stop_.name = move(name_);
+			result_.stops_to_add.push_back(move(stop_));
+		}
+		else if (type_ == "Bus"sv) {
+			CheckFields(NAME | IS_ROUNDTRIP | STOPS);
+			bus_.name = move(name_);
+			result_.buses_to_add.push_back(move(bus_));
+		}
+		else if (type_.empty()) {
+			throw invalid_argument("Base request has no type"s);
+		}
+	}
+
+	// Значение поля запроса
+	void SetField(string_view value) {
+		if (field_ == "type"sv) {
+			type_ = value;
+		}
+		else if (field_ == "name"sv) {
+			name_ = value;
+		}
+		else {
+			CheckUnknownField();
+		}
+	}
+
+	void SetField(double value) {
+		if (field_ == "latitude"sv) {
+			stop_.location.lat = value;
+		}
+		else if (field_ == "longitude"sv) {
+			stop_.location.lng = value;
+		}
+		else {
+			CheckUnknownField();
+		}
+	}
+
+	void SetField(int value) {
+		SetField(static_cast<double>(value));
+	}
+
+	void SetField(bool value) {
+		if (field_ == "is_roundtrip"sv) {
+			bus_.is_circle = value;
+		}
+		else {
+			CheckUnknownField();
+		}
+	}
+
+	void SetField(nullptr_t) {
+		CheckUnknownField();
+	}
+
+	// Поля запроса с известным названием должны иметь значение нужного типа,
+	// остальные поля пропускаются
+	void CheckUnknownField() const {
+		for (string_view known : { "type"sv, "name"sv, "latitude"sv, "longitude"sv, "is_roundtrip"sv,
+			"road_distances"sv, "stops"sv }) {
+			if (field_ == known) {
+				throw invalid_argument("Unexpected value of base request field "s + field_);
+			}
+		}
+	}
+
+	// Элемент списка расстояний или остановок маршрута
+	void AddListItem(int value) {
+		if (field_ == "road_distances"sv) {
+			stop_.distances_to_stops.emplace_back(move(distance_stop_), value);
+		}
+		else if (field_ == "stops"sv) {
+			throw invalid_argument("Stop name must be a string"s);
+		}
+	}
+
+	void AddListItem(string_view value) {
+		if (field_ == "stops"sv) {
+			bus_.stops.emplace_back(value);
+		}
+		else if (field_ == "road_distances"sv) {
+			throw invalid_argument("Road distance must be an int"s);
+		}
+	}
+
+	template <typename Scalar>
+	void AddListItem(Scalar&&) {
+		if (field_ == "road_distances"sv || field_ == "stops"sv) {
+			throw invalid_argument("Unexpected value in base request field "s + field_);
+		}
+	}
+};
 
 map_renderer::RenderSettings GetRenderSettings(const json::Node& input_base) {
 	map_renderer::RenderSettings settings;
@@ -100,43 +535,43 @@ map_renderer::RenderSettings GetRenderSettings(const json::Node& input_base) {
 	auto& set_map = input_base.AsDict();
 
 	// размеры поля
-	settings.width = set_map.at("width"s).AsDouble();
-	settings.height = set_map.at("height"s).AsDouble();
+	settings.width = set_map.at("width"sv).AsDouble();
+	settings.height = set_map.at("height"sv).AsDouble();
 
 	// отступ
-	settings.padding = set_map.at("padding"s).AsDouble();
+	settings.padding = set_map.at("padding"sv).AsDouble();
 
 	// Знак остановки
-	settings.stop_radius = set_map.at("stop_radius"s).AsDouble();
+	settings.stop_radius = set_map.at("stop_radius"sv).AsDouble();
 
 	// Толщина линий маршрутов
-	settings.line_width = set_map.at("line_width"s).AsDouble();
+	settings.line_width = set_map.at("line_width"sv).AsDouble();
 
 	// Отображение названия маршрута
-	settings.bus_label_font_size = set_map.at("bus_label_font_size"s).AsInt();
+	settings.bus_label_font_size = set_map.at("bus_label_font_size"sv).AsInt();
 
 	// Положение названия маршрута
-	auto& bus_name_loc = set_map.at("bus_label_offset"s).AsArray();
+	auto& bus_name_loc = set_map.at("bus_label_offset"sv).AsArray();
 	settings.bus_label_dx = bus_name_loc[0].AsDouble();
 	settings.bus_label_dy = bus_name_loc[1].AsDouble();
 
 	// Отображение названия остановки
-	settings.stop_label_font_size = set_map.at("stop_label_font_size"s).AsInt();
+	settings.stop_label_font_size = set_map.at("stop_label_font_size"sv).AsInt();
 
 	// Положение названия остановки
-	auto& stop_name_loc = set_map.at("stop_label_offset"s).AsArray();
+	auto& stop_name_loc = set_map.at("stop_label_offset"sv).AsArray();
 	settings.stop_label_dx = stop_name_loc[0].AsDouble();
 	settings.stop_label_dy = stop_name_loc[1].AsDouble();
 
 	// Цвет подложки
-	auto& underlayer_color_ptr = set_map.at("underlayer_color"s);
+	auto& underlayer_color_ptr = set_map.at("underlayer_color"sv);
 	settings.underlayer_color = ParseColor(underlayer_color_ptr);
 
 	// Толщина подложки под названиями остановок и маршрутов
-	settings.underlayer_width = set_map.at("underlayer_width"s).AsDouble();
+	settings.underlayer_width = set_map.at("underlayer_width"sv).AsDouble();
 
 	// Набор цветов для отрисовки
-	auto& color_pallet_array = set_map.at("color_palette"s).AsArray();
+	auto& color_pallet_array = set_map.at("color_palette"sv).AsArray();
 	settings.color_pallete.reserve(color_pallet_array.size());
 	for (auto& color : color_pallet_array) {
 		settings.color_pallete.push_back(ParseColor(color));
@@ -145,94 +580,332 @@ map_renderer::RenderSettings GetRenderSettings(const json::Node& input_base) {
 	return settings;
 }
 
-deque<transport_catalogue::RequestInfo> GetRequestsList(const json::Array& requests) {
-	using namespace transport_catalogue;
+// Обязательное строковое поле запроса
+string GetStringField(const json::Dict& fields, string_view key) {
+	return string(fields.at(key).AsString());
+}
 
-	deque<RequestInfo> result;
+// Обязательное поле запроса с количеством. Отрицательное значение считается нулем,
+// значение больше наибольшего size_t - наибольшим size_t
+size_t GetCountField(const json::Dict& fields, string_view key) {
+	const double count = fields.at(key).AsDouble();
+	if (!(count > 0.0)) {
+		return 0;
+	}
 
-	for (auto& request_json : requests) {
-		RequestInfo request;
+	// Наибольший size_t при переводе в double округляется до степени двойки, которая
+	// в size_t уже не помещается, поэтому граница проверяется нестрого
+	if (count >= static_cast<double>(numeric_limits<size_t>::max())) {
+		return numeric_limits<size_t>::max();
+	}
+	return static_cast<size_t>(count);
+}
 
-		for (const auto& [key, item] : request_json.AsDict()) {
-			if (key == "id"s) {
-				request.id = item.AsInt();
-			}
-			else {
-				request.request_items[key] = item.AsString();
-			}
-		}
+// Поле kind запроса Autocomplete. Неизвестное значение - ошибка разбора запроса,
+// как и неизвестный тип запроса
+transport_catalogue::AutocompleteKind GetAutocompleteKind(const json::Dict& fields) {
+	const string_view kind = fields.at("kind"sv).AsString();
+	if (kind == "Stop"sv) {
+		return transport_catalogue::AutocompleteKind::STOP;
+	}
+	if (kind == "Bus"sv) {
+		return transport_catalogue::AutocompleteKind::BUS;
+	}
+	throw invalid_argument("Unknown autocomplete kind "s + string(kind));
+}
 
-		result.push_back(move(request));
+// Список названий из поля запроса
+vector<string> GetNameList(const json::Node& list_json) {
+	vector<string> result;
+	result.reserve(list_json.AsArray().size());
+	for (const auto& item : list_json.AsArray()) {
+		result.emplace_back(item.AsString());
 	}
+	return result;
+}
 
+// Сценарий запроса по полям closed_stops и closed_buses. nullopt, если их нет
+optional<transport_catalogue::ClosedNames> GetClosedNames(const json::Dict& fields) {
+	auto stops_it = fields.find("closed_stops"sv);
+	auto buses_it = fields.find("closed_buses"sv);
+	if (stops_it == fields.end() && buses_it == fields.end()) {
+		return nullopt;
+	}
+
+	transport_catalogue::ClosedNames result;
+	if (stops_it != fields.end()) {
+		result.stops = GetNameList(stops_it->second);
+	}
+	if (buses_it != fields.end()) {
+		result.buses = GetNameList(buses_it->second);
+	}
 	return result;
 }
 
+// Разбор запроса stat_requests в структуру его типа. Поля, не относящиеся к типу, пропускаются
+transport_catalogue::RequestInfo GetRequest(const json::Node& request_json) {
+	using namespace transport_catalogue;
+
+	const json::Dict& fields = request_json.AsDict();
+
+	RequestInfo request;
+	request.id = fields.at("id"sv).AsInt();
+
+	const string_view type = fields.at("type"sv).AsString();
+	if (type == "Stop"sv) {
+		request.fields = StopRequest{ GetStringField(fields, "name"sv) };
+	}
+	else if (type == "Bus"sv) {
+		request.fields = BusRequest{ GetStringField(fields, "name"sv), GetClosedNames(fields) };
+	}
+	else if (type == "Route"sv) {
+		request.fields = RouteRequest{ GetStringField(fields, "from"sv), GetStringField(fields, "to"sv), GetClosedNames(fields) };
+	}
+	else if (type == "NearestStops"sv) {
+		request.fields = NearestStopsRequest{
+			{ fields.at("latitude"sv).AsDouble(), fields.at("longitude"sv).AsDouble() },
+			GetCountField(fields, "count"sv) };
+	}
+	else if (type == "Autocomplete"sv) {
+		request.fields = AutocompleteRequest{
+			GetAutocompleteKind(fields), GetStringField(fields, "prefix"sv), GetCountField(fields, "count"sv) };
+	}
+	else if (type == "DirectBuses"sv) {
+		request.fields = DirectBusesRequest{ GetStringField(fields, "from"sv), GetStringField(fields, "to"sv) };
+	}
+	else if (type == "Analytics"sv) {
+		// Размер рейтингов необязателен
+		AnalyticsRequest analytics;
+		if (fields.count("count"sv) != 0) {
+			analytics.count = GetCountField(fields, "count"sv);
+		}
+		request.fields = analytics;
+	}
+	else if (type == "Stats"sv) {
+		request.fields = StatsRequest{};
+	}
+	else if (type == "Map"sv) {
+		request.fields = MapRequest{};
+	}
+	else if (type == "RemoveStop"sv) {
+		request.fields = RemoveStopRequest{ GetStringField(fields, "name"sv) };
+	}
+	else if (type == "RemoveBus"sv) {
+		request.fields = RemoveBusRequest{ GetStringField(fields, "name"sv) };
+	}
+	else if (type == "SetDistance"sv) {
+		request.fields = SetDistanceRequest{
+			GetStringField(fields, "from"sv), GetStringField(fields, "to"sv), fields.at("distance"sv).AsInt() };
+	}
+	else {
+		throw invalid_argument("Unknown request type "s + string(type));
+	}
+
+	return request;
+}
+
+
 } // End of details
 
-// Чтение json для транспортного каталога
-InputQueries ReadTransportJson(std::istream& input) {
-	
-	InputQueries result;
+namespace details {
+
+// Количество запросов base_requests в одном блоке параллельного разбора
+constexpr size_t BASE_CHUNK_SIZE = 1024;
 
-	// JSON база данных
-	const auto input_database = json::Load(input);
+// Минимальное количество блоков на поток. Разбор блока запросов дороже запуска
+// потока, поэтому поток запускается уже для одного блока
+constexpr size_t BASE_CHUNKS_PER_THREAD = 1;
 
-	// { - Dict
-	// [ - Array
+// Проверка, что в части текста после значения только пробельные символы
+void CheckRestIsBlank(string_view rest) {
+	if (rest.find_first_not_of(" \t\r\n"sv) != string_view::npos) {
+		throw json::ParsingError("Unexpected characters after value"s);
+	}
+}
 
-	// Проверка, что корневой узел - словарь
-	if (!input_database.GetRoot().IsDict()) {
-		throw invalid_argument("Root isn't a Dict");
+// Разбор запросов base_requests из частей текста [begin, end) в списки partial
+void ParseBaseRequests(const vector<string_view>& elements, size_t begin, size_t end, InputQueries& partial) {
+	std::pmr::monotonic_buffer_resource arena;
+	json::Dict sections{ json::Dict::allocator_type(&arena) };
+	InputHandler handler(partial, sections, &arena);
+
+	// Запросы блока идут в тексте подряд через запятую и разбираются одним разборщиком
+	const char* const text_begin = elements[begin].data();
+	const char* const text_end = elements[end - 1].data() + elements[end - 1].size();
+	json::BufferSource source(string_view(text_begin, static_cast<size_t>(text_end - text_begin)));
+	json::details::Parser<json::BufferSource, InputHandler> parser(source, handler);
+
+	// Обработчик получает те же события, что и при разборе документа с одним разделом base_requests
+	handler.StartDict();
+	handler.Key("base_requests"sv);
+	handler.StartArray();
+	for (size_t i = begin; i < end; ++i) {
+		parser.ParseValue();
+
+		// Запрос должен занимать свою часть текста целиком. Запятая после него пропускается
+		const string_view rest = source.GetRest();
+		const char* const element_end = elements[i].data() + elements[i].size();
+		if (rest.data() > element_end) {
+			throw json::ParsingError("Array parsing error"s);
+		}
+		const size_t element_rest = static_cast<size_t>(element_end - rest.data());
+		CheckRestIsBlank(rest.substr(0, element_rest));
+		source.Skip(min(rest.size(), element_rest + 1));
 	}
+	handler.EndArray();
+	handler.EndDict();
+}
 
-	const json::Dict& command_list = input_database.GetRoot().AsDict();
-	
-	// Проверка, что есть запросы типа base_request
-	if (command_list.count("base_requests"s) != 0) {
-		auto& base_requests_array = command_list.at("base_requests"s).AsArray();
+// Проверка, что первый значащий символ текста равен c
+bool StartsWith(string_view text, char c) {
+	const size_t pos = text.find_first_not_of(" \t\r\n"sv);
+	return pos != string_view::npos && text[pos] == c;
+}
+
+// Параллельный разбор массива base_requests. Границы запросов находятся структурным
+// просмотром, затем блоки запросов разбираются в потоках, а их результаты
+// добавляются в result в порядке документа
+void ReadBaseRequests(json::BufferSource& source, InputQueries& result) {
+	if (StartsWith(source.GetRest(), '{')) {
+		throw invalid_argument("base_requests must be an array"s);
+	}
+
+	const vector<string_view> elements = json::SplitArray(source);
+
+	// Сообщается первая в порядке документа ошибка
+	vector<InputQueries> partials = parallel::MapChunks<InputQueries>(elements.size(), BASE_CHUNK_SIZE, BASE_CHUNKS_PER_THREAD,
+		[&elements](size_t begin, size_t end) {
+			InputQueries partial;
+			ParseBaseRequests(elements, begin, end, partial);
+			return partial;
+		});
+
+	for (InputQueries& partial : partials) {
+		move(partial.stops_to_add.begin(), partial.stops_to_add.end(), back_inserter(result.stops_to_add));
+		move(partial.buses_to_add.begin(), partial.buses_to_add.end(), back_inserter(result.buses_to_add));
+	}
+}
+
+// Потоковый разбор документа из потока ввода
+void ParseDocument(json::StreamSource& source, InputHandler& handler, InputQueries&) {
+	json::Parse(source, handler);
+}
 
-		result.stops_to_add = details::GetStopsList(base_requests_array);
-		result.buses_to_add = details::GetBusesList(base_requests_array);
+// Разбор документа из буфера. Массив base_requests разбирается параллельно,
+// остальные разделы передаются обработчику так же, как при потоковом разборе
+void ParseDocument(json::BufferSource& source, InputHandler& handler, InputQueries& result) {
+	// На одном процессоре структурный просмотр не окупается
+	if (parallel::GetHardwareThreads() <= 1) {
+		json::Parse(source, handler);
+		return;
 	}
 
+	if (StartsWith(source.GetRest(), '[')) {
+		throw invalid_argument("Root isn't a Dict"s);
+	}
+
+	handler.StartDict();
+	json::ParseDictEntries(source, [&](string_view key) {
+		if (key == "base_requests"sv) {
+			handler.CheckSectionKey(key);
+			ReadBaseRequests(source, result);
+		}
+		else {
+			handler.Key(key);
+			json::Parse(source, handler);
+		}
+	});
+	handler.EndDict();
+}
+
+// Чтение json для транспортного каталога из источника символов
+template <typename Source>
+InputQueries ReadTransportJson(Source& source) {
+	
+	InputQueries result;
+
+	// Потоковый разбор документа. Запросы base_requests и stat_requests сразу переносятся
+	// в списки остановок, маршрутов и запросов, остальные разделы собираются в словарь.
+	// Узлы разделов размещаются в арене и освобождаются вместе с ней
+	std::pmr::monotonic_buffer_resource arena;
+	json::Dict command_list{ json::Dict::allocator_type(&arena) };
+	InputHandler handler(result, command_list, &arena);
+	ParseDocument(source, handler, result);
+
 	// Проверка, что есть запросы типа render_settings
-	if (command_list.count("render_settings"s) != 0) {
+	if (command_list.count("render_settings"sv) != 0) {
 		// Указатель на массив с render_settings
-		auto& render_settings_ptr = command_list.at("render_settings"s);
+		auto& render_settings_ptr = command_list.at("render_settings"sv);
 
 		// Парсинг парметров
-		result.render_settings = details::GetRenderSettings(render_settings_ptr);
+		result.render_settings = GetRenderSettings(render_settings_ptr);
 	}
 	
 	// Проверка, что есть запросы типа routing_settings
-	if (command_list.count("routing_settings"s) != 0) {
+	if (command_list.count("routing_settings"sv) != 0) {
 		// Указатель на словарь с route_settings
-		auto& route_settings_dict = command_list.at("routing_settings"s).AsDict();
+		auto& route_settings_dict = command_list.at("routing_settings"sv).AsDict();
 
 		// Парсинг парметров
-		result.routing_settings.bus_velocity = route_settings_dict.at("bus_velocity"s).AsDouble();
-		result.routing_settings.bus_wait_time = route_settings_dict.at("bus_wait_time"s).AsInt();
+		result.routing_settings.bus_velocity = route_settings_dict.at("bus_velocity"sv).AsDouble();
+		result.routing_settings.bus_wait_time = route_settings_dict.at("bus_wait_time"sv).AsInt();
 	}
 
-	// Проверка, что есть запросы типа stat_requests
-	if (command_list.count("stat_requests"s) != 0) {
-		// Указатель на массив с stat_requests
-		auto& stat_requests_array = command_list.at("stat_requests"s).AsArray();
-
-		result.requests = details::GetRequestsList(stat_requests_array);
+	// Проверка, что есть настройки geo_settings
+	if (command_list.count("geo_settings"sv) != 0) {
+		auto& geo_settings_dict = command_list.at("geo_settings"sv).AsDict();
 
-		// Вывод данных в формате json
+		if (geo_settings_dict.count("distance_mode"sv) != 0) {
+			string_view mode_name = geo_settings_dict.at("distance_mode"sv).AsString();
+			auto mode = geo::ParseDistanceMode(mode_name);
+			if (!mode) {
+				throw invalid_argument("Unknown distance mode: "s + string(mode_name));
+			}
+			result.distance_mode = *mode;
+		}
 	}
 
 	// Проверка, что есть запросы типа serialization_settings
-	if (command_list.count("serialization_settings"s) != 0) {
+	if (command_list.count("serialization_settings"sv) != 0) {
 		// Указатель на словарь с stat_requests
-		auto& serialization_settings_dict = command_list.at("serialization_settings"s).AsDict();
-		result.ser_settings.file_name = serialization_settings_dict.at("file"s).AsString();
+		auto& serialization_settings_dict = command_list.at("serialization_settings"sv).AsDict();
+		result.ser_settings.file_name = serialization_settings_dict.at("file"sv).AsString();
+
+		if (serialization_settings_dict.count("reload_interval_ms"sv) != 0) {
+			result.ser_settings.reload_interval_ms = serialization_settings_dict.at("reload_interval_ms"sv).AsInt();
+		}
 	}
 	
 	return result;
 }
 
+} // End of details
+
+// Чтение json для транспортного каталога
+InputQueries ReadTransportJson(std::istream& input) {
+	json::StreamSource source(input);
+	return details::ReadTransportJson(source);
+}
+
+// Чтение json для транспортного каталога из буфера
+InputQueries ReadTransportJson(std::string_view& input) {
+	json::BufferSource source(input);
+	InputQueries result = details::ReadTransportJson(source);
+	input = source.GetRest();
+	return result;
+}
+
+// Чтение одного запроса из строки
+transport_catalogue::RequestInfo ReadRequest(std::string_view line) {
+	json::BufferSource source(line);
+	std::pmr::monotonic_buffer_resource arena;
+	json::DomBuilder builder(&arena);
+	json::Parse(source, builder);
+
+	// После запроса в строке допустимы только пробельные символы
+	details::CheckRestIsBlank(source.GetRest());
+
+	return details::GetRequest(builder.Extract());
+}
+
 } // End of json_reader
\ No newline at end of file
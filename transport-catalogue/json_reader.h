@@ -9,6 +9,7 @@
 
 #include <deque>
 #include <string>
+#include <string_view>
 
 /*
  * Здесь можно разместить код наполнения транспортного справочника данными из JSON,
@@ -22,6 +23,8 @@ struct InputQueries{
 	std::deque<transport_catalogue::RequestInfo> requests;
 	map_renderer::RenderSettings render_settings;
 	transport_router::RoutingSettings routing_settings;
+	// geo_settings
+	geo::DistanceMode distance_mode = geo::DistanceMode::SPHERICAL;
 	// serialization_settings
 	serialization::Settings ser_settings;
 };
@@ -29,4 +32,11 @@ struct InputQueries{
 // Чтение json для транспортного каталога
 InputQueries ReadTransportJson(std::istream& input);
 
+// Чтение json для транспортного каталога из буфера. Разобранный документ
+// удаляется из начала input
+InputQueries ReadTransportJson(std::string_view& input);
+
+// Чтение одного запроса stat_requests, записанного в строке line как объект JSON
+transport_catalogue::RequestInfo ReadRequest(std::string_view line);
+
 }
\ No newline at end of file
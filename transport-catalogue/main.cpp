@@ -2,69 +2,207 @@
 #include <iostream>
 #include <string_view>
 
+#include "analytics.h"
+#include "binary_protocol.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "mapped_file.h"
 #include "request_handler.h"
 #include "transport_catalogue.h"
 #include "serialization.h"
+#include "snapshot.h"
 
+#include <chrono>
+#include <memory>
 #include <optional>
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|serve_requests|serve_lines|check_distance]\n"sv
+        << "       transport_catalogue process_requests --binary\n"sv;
+}
+
+// Чтение первого документа из стандартного ввода. Если ввод перенаправлен из обычного
+// файла, файл отображается в память и разбирается из буфера, а позиция чтения
+// переносится за документ, чтобы следующие документы читались из потока
+json_reader::InputQueries ReadInput() {
+    if (auto file = mapped_file::MappedFile::Map(0)) {
+        std::string_view text = file->GetText();
+        json_reader::InputQueries result = json_reader::ReadTransportJson(text);
+        file->Consume(file->GetText().size() - text.size());
+        return result;
+    }
+    return json_reader::ReadTransportJson(std::cin);
+}
+
+// Обработка пакета запросов в двоичном формате: сообщение RequestBatch читается
+// из стандартного ввода, ответы выводятся сообщениями Response
+int ProcessBinaryRequests() {
+    const binary_protocol::RequestBatch batch = binary_protocol::ReadRequestBatch(std::cin);
+
+    std::shared_ptr<snapshot::Snapshot> base = snapshot::LoadSnapshot(batch.ser_settings);
+    if (!base) {
+        std::cerr << "Can't read database" << std::endl;
+        return 1;
+    }
+
+    request_handler::RequestHandler request_handler(std::move(base));
+    binary_protocol::WriteResponses(request_handler, batch.requests, std::cout);
+
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    const bool binary = argc == 3 && argv[1] == "process_requests"sv && argv[2] == "--binary"sv;
+    if (argc != 2 && !binary) {
         PrintUsage();
         return 1;
     }
 
+    // Собственные буферы потоков вместо посимвольной синхронизации с stdio:
+    // ответы выводятся блоками по мере заполнения буфера
+    std::ios::sync_with_stdio(false);
+
+    if (binary) {
+        return ProcessBinaryRequests();
+    }
+
     //std::cout << "main.cpp " << "(" << __LINE__ << ") " << std::endl;
     const std::string_view mode(argv[1]);
 
     // Считывание JSON
     // Чтение файла json и формирование базы запросов
-    json_reader::InputQueries queries = json_reader::ReadTransportJson(std::cin);
+    json_reader::InputQueries queries = ReadInput();
 
     if (mode == "make_base"sv) {
         // make base here
+        // Ответы на запросы Stop и Bus не зависят от запросов, поэтому формируются
+        // по каталогу один раз и сохраняются в базу
+        transport_catalogue::TransportCatalogue catalogue;
+        catalogue.SetDistanceMode(queries.distance_mode);
+        catalogue.FillCatalogue(queries.stops_to_add, queries.buses_to_add);
+
         serialization::Serialize(
             queries.stops_to_add,
             queries.buses_to_add,
             queries.render_settings,
             queries.routing_settings,
-            queries.ser_settings);
+            queries.ser_settings,
+            queries.distance_mode,
+            request_handler::MaterializeResponses(catalogue));
 
     } else if (mode == "process_requests"sv) {
         // process requests here
-        std::optional<serialization::DeserializedParameters> input = serialization::Deserialize(queries.ser_settings);
+        std::shared_ptr<snapshot::Snapshot> base = snapshot::LoadSnapshot(queries.ser_settings);
 
-        if (!input) {
+        if (!base) {
             std::cout << "Can't read database" << std::endl;
         }
         else {
-            // База данных для работы
-            transport_catalogue::TransportCatalogue catalogue;
-            catalogue.FillCatalogue(input.value().stops_to_add, input.value().buses_to_add);
+            // Обработчик запросов
+            request_handler::RequestHandler request_handler(std::move(base));
 
-            // Обработчик маршрутов со встроенным графом маршрутов
-            transport_router::TransportRouter transport_router(catalogue, input.value().routing_settings);
+            // Вывод ответов в формате json по мере их формирования
+            request_handler.WriteJsonResponce(queries.requests, std::cout);
 
-            // Обработчик графа маршрутов
-            graph::Router<double> router(transport_router.GetGraph());
+        }
+    } else if (mode == "serve_requests"sv) {
+        // Долгоживущий режим: документы с stat_requests читаются из потока один за другим,
+        // а база перезагружается в фоне при изменении файла
+        snapshot::SnapshotHolder holder;
+        holder.Publish(snapshot::LoadSnapshot(queries.ser_settings));
 
-            // Отрисовщик карты маршрутов в формате SVG
-            map_renderer::MapRenderer renderer(input.value().render_settings);
+        if (!holder.Get()) {
+            std::cout << "Can't read database" << std::endl;
+            return 1;
+        }
 
-            // Обработчик запросов
-            request_handler::RequestHandler request_handler(catalogue, renderer, transport_router, router);
+        snapshot::BaseReloader reloader(holder, queries.ser_settings,
+            std::chrono::milliseconds(queries.ser_settings.reload_interval_ms));
+
+        while (true) {
+            if (!queries.requests.empty()) {
+                // Каждый документ обрабатывается по одному снимку базы
+                request_handler::RequestHandler request_handler(holder.Get());
+
+                request_handler.WriteJsonResponce(queries.requests, std::cout);
+                std::cout << std::endl;
+            }
+
+            // Переход к следующему документу или завершение по концу потока
+            if ((std::cin >> std::ws).peek() == std::char_traits<char>::eof()) {
+                break;
+            }
+            queries = json_reader::ReadTransportJson(std::cin);
+        }
+    } else if (mode == "serve_lines"sv) {
+        // Режим JSON Lines: после документа с настройками каждая строка ввода содержит
+        // один запрос, а ответ на нее выводится одной строкой
+        snapshot::SnapshotHolder holder;
+        holder.Publish(snapshot::LoadSnapshot(queries.ser_settings));
+
+        if (!holder.Get()) {
+            std::cout << "Can't read database" << std::endl;
+            return 1;
+        }
+
+        snapshot::BaseReloader reloader(holder, queries.ser_settings,
+            std::chrono::milliseconds(queries.ser_settings.reload_interval_ms));
+
+        // Ответ на запрос или сообщение об ошибке разбора и обработки строки.
+        // Если запрос удалось разобрать, сообщение содержит его номер
+        auto answer = [&holder](const auto& read_request) {
+            std::optional<int> request_id;
+            try {
+                const auto& request = read_request();
+                request_id = request.id;
+
+                request_handler::RequestHandler request_handler(holder.Get());
+                json::PrintCompact(request_handler.GetResponse(request), std::cout);
+            }
+            catch (const std::exception& e) {
+                json::Dict error{ { "error_message"sv, std::string(e.what()) } };
+                if (request_id) {
+                    error.emplace("request_id"sv, *request_id);
+                }
+                json::PrintCompact(error, std::cout);
+            }
+            std::cout.put('\n');
+        };
 
-            // Вывод запросов в формате json
-            json::Document json_responce = request_handler.GetJsonResponce(queries.requests);
-            json::Print(json_responce, std::cout);
+        // Запросы из документа с настройками отвечаются первыми
+        for (const auto& request : queries.requests) {
+            answer([&request]() -> const auto& { return request; });
+        }
+        std::cout.flush();
+
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.find_first_not_of(" \t\r"sv) == std::string::npos) {
+                continue;
+            }
+            answer([&line] { return json_reader::ReadRequest(line); });
+
+            // Вывод сбрасывается, когда прочитаны все поступившие строки: по одной
+            // строке в интерактивном режиме и пакетами при потоке запросов
+            if (std::cin.rdbuf()->in_avail() <= 0) {
+                std::cout.flush();
+            }
+        }
+    } else if (mode == "check_distance"sv) {
+        // Проверка точности приближенных способов расчета расстояний на отрезках
+        // маршрутов из base_requests относительно сферической теоремы косинусов
+        transport_catalogue::TransportCatalogue catalogue;
+        catalogue.FillCatalogue(queries.stops_to_add, queries.buses_to_add);
 
+        for (geo::DistanceMode distance_mode : { geo::DistanceMode::HAVERSINE, geo::DistanceMode::EQUIRECTANGULAR }) {
+            const analytics::DistanceAccuracy accuracy = analytics::MeasureDistanceAccuracy(catalogue, distance_mode);
+            std::cout << geo::GetDistanceModeName(distance_mode) << ": segments "sv << accuracy.segment_count
+                << ", max error "sv << accuracy.max_abs_error << " m"sv
+                << ", mean error "sv << accuracy.mean_abs_error << " m"sv
+                << ", max relative error "sv << accuracy.max_rel_error
+                << ", time "sv << accuracy.mode_ns_per_segment << " ns/segment"sv
+                << " (spherical "sv << accuracy.reference_ns_per_segment << " ns/segment)"sv << std::endl;
         }
     } else {
         PrintUsage();
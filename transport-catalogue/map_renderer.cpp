@@ -20,6 +20,45 @@ namespace map_renderer {
     }
 
 
+    // Построение по массивам координат остановок. Учитываются только остановки,
+    // отмеченные в used по их номерам
+    SphereProjector::SphereProjector(const transport_catalogue::StopArrays& stops, const std::vector<bool>& used,
+        double max_width, double max_height, double padding)
+        : padding_(padding) {
+        // Границы области находятся одним проходом по массивам координат
+        bool found = false;
+        double min_lon = 0, max_lon = 0, min_lat = 0, max_lat = 0;
+
+        for (size_t i = 0; i < stops.size; ++i) {
+            if (!used[i]) {
+                continue;
+            }
+
+            const double lat = stops.lat[i];
+            const double lng = stops.lng[i];
+
+            if (!found) {
+                min_lon = max_lon = lng;
+                min_lat = max_lat = lat;
+                found = true;
+                continue;
+            }
+
+            min_lon = std::min(min_lon, lng);
+            max_lon = std::max(max_lon, lng);
+            min_lat = std::min(min_lat, lat);
+            max_lat = std::max(max_lat, lat);
+        }
+
+        // Если точки поверхности сферы не заданы, вычислять нечего
+        if (!found) {
+            return;
+        }
+
+        SetBounds(min_lon, max_lon, min_lat, max_lat, max_width, max_height);
+    }
+
+
     // ---------- MapRenderer ----------
 
     // Применить настройки извне
@@ -28,22 +67,21 @@ namespace map_renderer {
     }
 
     svg::Document MapRenderer::GenerateMap(
-        const std::vector<const transport_catalogue::Bus*>& bus_list) const {
-
-        // Хранилище на указатели координат
-        std::deque<geo::Coordinates> coordinates_list;
+        const std::vector<const transport_catalogue::Bus*>& bus_list,
+        const transport_catalogue::StopArrays& stops) const {
 
-        // Получение всех координат из  всех маршрутов
+        // Отметки остановок, через которые проходят маршруты
+        std::vector<bool> used_stops(stops.size, false);
         for (auto& bus : bus_list) {
-            for (auto& stop : bus->stops_) {
-                coordinates_list.push_back(stop->location_);
+            for (const auto& stop : bus->stops_) {
+                used_stops[stop->id_] = true;
             }
         }
 
         // Создаем преобразователь координат
         SphereProjector map_converter(
-            coordinates_list.begin(),
-            coordinates_list.end(),
+            stops,
+            used_stops,
             settings_.width,
             settings_.height,
             settings_.padding);
@@ -147,7 +185,7 @@ namespace map_renderer {
         route.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
         // В маршруте проходим по списку остановок и добавляем точки в линию
-        for (auto& stop : bus->stops_) {
+        for (const auto& stop : bus->stops_) {
             route.AddPoint(map_converter(stop->location_));
         }
 
@@ -175,7 +213,7 @@ namespace map_renderer {
             .SetPosition(map_converter(bus->stops_[0]->location_))
             .SetOffset({ settings_.bus_label_dx, settings_.bus_label_dy })
             .SetFontWeight("bold"s)
-            .SetData(bus->name_);
+            .SetData(string(bus->name_));
 
         return {
             svg::Text{ bus_name_base }
@@ -208,7 +246,7 @@ namespace map_renderer {
             .SetFontSize(settings_.stop_label_font_size)
             .SetPosition(map_converter(stop_ptr->location_))
             .SetOffset({ settings_.stop_label_dx, settings_.stop_label_dy })
-            .SetData(stop_ptr->name_);
+            .SetData(string(stop_ptr->name_));
 
         stop_image.stop_name.first =
             svg::Text{ stop_name_base }
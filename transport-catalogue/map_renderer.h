@@ -94,15 +94,40 @@ public:
         const auto [left_it, right_it] = std::minmax_element(
             points_begin, points_end,
             [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-        min_lon_ = left_it->lng;
-        const double max_lon = right_it->lng;
 
         // Находим точки с минимальной и максимальной широтой
         const auto [bottom_it, top_it] = std::minmax_element(
             points_begin, points_end,
             [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-        const double min_lat = bottom_it->lat;
-        max_lat_ = top_it->lat;
+
+        SetBounds(left_it->lng, right_it->lng, bottom_it->lat, top_it->lat, max_width, max_height);
+    }
+
+    // Построение по массивам координат остановок. Учитываются только остановки,
+    // отмеченные в used по их номерам
+    SphereProjector(const transport_catalogue::StopArrays& stops, const std::vector<bool>& used,
+        double max_width, double max_height, double padding);
+
+    // Проецирует широту и долготу в координаты внутри SVG-изображения
+    svg::Point operator()(geo::Coordinates coords) const {
+        return {
+            (coords.lng - min_lon_) * zoom_coeff_ + padding_,
+            (max_lat_ - coords.lat) * zoom_coeff_ + padding_
+        };
+    }
+
+private:
+    double padding_;
+    double min_lon_ = 0;
+    double max_lat_ = 0;
+    double zoom_coeff_ = 0;
+
+    // Расчет коэффициента масштабирования по границам области
+    void SetBounds(double min_lon, double max_lon, double min_lat, double max_lat,
+        double max_width, double max_height) {
+        min_lon_ = min_lon;
+        max_lat_ = max_lat;
+        const double padding = padding_;
 
         // Вычисляем коэффициент масштабирования вдоль координаты x
         std::optional<double> width_zoom;
@@ -130,20 +155,6 @@ public:
             zoom_coeff_ = *height_zoom;
         }
     }
-
-    // Проецирует широту и долготу в координаты внутри SVG-изображения
-    svg::Point operator()(geo::Coordinates coords) const {
-        return {
-            (coords.lng - min_lon_) * zoom_coeff_ + padding_,
-            (max_lat_ - coords.lat) * zoom_coeff_ + padding_
-        };
-    }
-
-private:
-    double padding_;
-    double min_lon_ = 0;
-    double max_lat_ = 0;
-    double zoom_coeff_ = 0;
 };
 
 
@@ -163,7 +174,8 @@ public:
     // Применить настройки извне
     void SetSettings(RenderSettings& settings);
 
-    svg::Document GenerateMap(const std::vector<const transport_catalogue::Bus*>& bus_list) const;
+    svg::Document GenerateMap(const std::vector<const transport_catalogue::Bus*>& bus_list,
+        const transport_catalogue::StopArrays& stops) const;
 
 private:
     RenderSettings settings_;
@@ -0,0 +1,85 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_POSIX
+#endif
+
+namespace mapped_file {
+
+using namespace std;
+
+MappedFile::MappedFile(int descriptor, void* data, size_t mapped_size, size_t offset)
+	: descriptor_(descriptor)
+	, data_(data)
+	, mapped_size_(mapped_size)
+	, offset_(offset) {
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: descriptor_(exchange(other.descriptor_, -1))
+	, data_(exchange(other.data_, nullptr))
+	, mapped_size_(exchange(other.mapped_size_, 0))
+	, offset_(exchange(other.offset_, 0)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		MappedFile moved(move(other));
+		swap(descriptor_, moved.descriptor_);
+		swap(data_, moved.data_);
+		swap(mapped_size_, moved.mapped_size_);
+		swap(offset_, moved.offset_);
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_POSIX
+	if (data_ != nullptr) {
+		munmap(data_, mapped_size_);
+	}
+#endif
+}
+
+optional<MappedFile> MappedFile::Map([[maybe_unused]] int descriptor) {
+#ifdef MAPPED_FILE_POSIX
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode)) {
+		return nullopt;
+	}
+
+	const off_t offset = lseek(descriptor, 0, SEEK_CUR);
+	if (offset < 0 || offset >= info.st_size) {
+		return nullopt;
+	}
+
+	// Отображается весь файл: смещение mmap должно быть кратно размеру страницы
+	const size_t size = static_cast<size_t>(info.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (data == MAP_FAILED) {
+		return nullopt;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	return MappedFile(descriptor, data, size, static_cast<size_t>(offset));
+#else
+	return nullopt;
+#endif
+}
+
+string_view MappedFile::GetText() const {
+	return { static_cast<const char*>(data_) + offset_, mapped_size_ - offset_ };
+}
+
+void MappedFile::Consume([[maybe_unused]] size_t size) const {
+#ifdef MAPPED_FILE_POSIX
+	lseek(descriptor_, static_cast<off_t>(offset_ + size), SEEK_SET);
+#endif
+}
+
+} // End of mapped_file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace mapped_file {
+
+// Файл, отображенный в память только для чтения. Текст начинается с позиции чтения
+// дескриптора на момент отображения. Отображение снимается в деструкторе.
+// Поддерживается только на POSIX-системах, на остальных Map всегда возвращает nullopt
+class MappedFile {
+public:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	~MappedFile();
+
+	// Отображение открытого на чтение дескриптора. Возвращает nullopt, если дескриптор
+	// не относится к обычному файлу (канал, терминал), файл пуст или отображение не удалось
+	static std::optional<MappedFile> Map(int descriptor);
+
+	std::string_view GetText() const;
+
+	// Перенос позиции чтения дескриптора на size символов от начала текста,
+	// чтобы дальнейшее чтение из него продолжилось после уже разобранной части
+	void Consume(size_t size) const;
+
+private:
+	MappedFile(int descriptor, void* data, size_t mapped_size, size_t offset);
+
+	int descriptor_ = -1;
+	void* data_ = nullptr;
+	size_t mapped_size_ = 0;
+	size_t offset_ = 0;
+};
+
+} // End of mapped_file
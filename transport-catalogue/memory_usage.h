@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace memory_usage {
+
+// Расход памяти одной части базы: количество элементов и занимаемый объем в байтах.
+// Объем контейнеров оценивается по их емкости и размеру узлов стандартной библиотеки,
+// без учета служебных данных распределителя памяти
+struct Usage {
+	size_t count = 0;
+	size_t bytes = 0;
+};
+
+// Расход памяти по частям компонента
+using Report = std::map<std::string, Usage>;
+
+// Размер узла в списке хеш-таблицы: указатель на следующий узел и сохраненный хеш
+inline constexpr size_t HASH_NODE_OVERHEAD = 2 * sizeof(void*);
+
+// Размер узла красно-черного дерева: три указателя и цвет
+inline constexpr size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+
+template <typename T>
+size_t Bytes(const std::vector<T>& items) {
+	return items.capacity() * sizeof(T);
+}
+
+inline size_t Bytes(const std::vector<bool>& items) {
+	return (items.capacity() + 7) / 8;
+}
+
+template <typename T>
+size_t Bytes(const std::deque<T>& items) {
+	return items.size() * sizeof(T);
+}
+
+template <typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t Bytes(const std::unordered_map<Key, Value, Hash, Equal, Alloc>& items) {
+	return items.bucket_count() * sizeof(void*)
+		+ items.size() * (sizeof(std::pair<const Key, Value>) + HASH_NODE_OVERHEAD);
+}
+
+template <typename Key, typename Hash, typename Equal, typename Alloc>
+size_t Bytes(const std::unordered_set<Key, Hash, Equal, Alloc>& items) {
+	return items.bucket_count() * sizeof(void*) + items.size() * (sizeof(Key) + HASH_NODE_OVERHEAD);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+size_t Bytes(const std::set<Key, Compare, Alloc>& items) {
+	return items.size() * (sizeof(Key) + TREE_NODE_OVERHEAD);
+}
+
+// Расход памяти контейнера с количеством элементов
+template <typename Container>
+Usage Of(const Container& items) {
+	return { items.size(), Bytes(items) };
+}
+
+// Общий объем памяти по всем частям
+inline size_t TotalBytes(const Report& report) {
+	size_t result = 0;
+	for (const auto& [name, usage] : report) {
+		result += usage.bytes;
+	}
+	return result;
+}
+
+} // End of memory_usage
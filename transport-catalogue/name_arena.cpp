@@ -0,0 +1,66 @@
+﻿#include "name_arena.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+using namespace std;
+
+// Добавление названия в арену. Возвращает стабильную ссылку на сохраненную строку
+string_view NameArena::Intern(string_view name) {
+	// Если такое название уже есть, то возвращаем ссылку на него
+	if (auto it = names_.find(name); it != names_.end()) {
+		return *it;
+	}
+
+	string_view stored = Store(name);
+	names_.insert(stored);
+
+	return stored;
+}
+
+// Количество уникальных названий
+size_t NameArena::GetNameCount() const {
+	return names_.size();
+}
+
+// Расход памяти на блоки с символами
+memory_usage::Usage NameArena::GetBlocksMemoryUsage() const {
+	return { blocks_.size(), allocated_bytes_ + memory_usage::Bytes(blocks_) };
+}
+
+// Расход памяти на набор названий
+memory_usage::Usage NameArena::GetNamesMemoryUsage() const {
+	return memory_usage::Of(names_);
+}
+
+// Копирование строки в память арены
+string_view NameArena::Store(string_view name) {
+	if (name.empty()) {
+		return {};
+	}
+
+	// Длинные названия получают собственный блок, чтобы не тратить
+	// остаток текущего блока
+	if (name.size() > BLOCK_SIZE / 4) {
+		char* begin = blocks_.emplace_back(make_unique<char[]>(name.size())).get();
+		allocated_bytes_ += name.size();
+		copy(name.begin(), name.end(), begin);
+		return { begin, name.size() };
+	}
+
+	// Если в текущем блоке не хватает места, то выделяем новый
+	if (block_used_ + name.size() > BLOCK_SIZE) {
+		current_block_ = blocks_.emplace_back(make_unique<char[]>(BLOCK_SIZE)).get();
+		allocated_bytes_ += BLOCK_SIZE;
+		block_used_ = 0;
+	}
+
+	char* begin = current_block_ + block_used_;
+	copy(name.begin(), name.end(), begin);
+	block_used_ += name.size();
+
+	return { begin, name.size() };
+}
+
+} // End of transport_catalogue
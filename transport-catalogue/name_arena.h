@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Хранилище уникальных названий остановок и маршрутов.
+// Строки копируются в большие блоки памяти и больше не перемещаются,
+// поэтому возвращаемые string_view остаются валидными все время жизни арены
+class NameArena {
+public:
+	NameArena() = default;
+
+	// Арена выдает ссылки на свою память, поэтому копирование запрещено
+	NameArena(const NameArena&) = delete;
+	NameArena& operator=(const NameArena&) = delete;
+
+	// Добавление названия в арену. Возвращает стабильную ссылку на сохраненную строку.
+	// Повторное добавление той же строки возвращает ту же ссылку
+	std::string_view Intern(std::string_view name);
+
+	// Количество уникальных названий
+	size_t GetNameCount() const;
+
+	// Расход памяти на блоки с символами и на набор названий
+	memory_usage::Usage GetBlocksMemoryUsage() const;
+	memory_usage::Usage GetNamesMemoryUsage() const;
+
+private:
+	// Размер одного блока памяти
+	static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+	// Блоки памяти с символами названий
+	std::vector<std::unique_ptr<char[]>> blocks_;
+
+	// Блок, в который добавляются короткие названия, и количество занятых в нем символов
+	char* current_block_ = nullptr;
+	size_t block_used_ = BLOCK_SIZE;
+
+	// Общий размер выделенных блоков
+	size_t allocated_bytes_ = 0;
+
+	// Набор ссылок на уже сохраненные названия
+	std::unordered_set<std::string_view> names_;
+
+	// Копирование строки в память арены
+	std::string_view Store(std::string_view name);
+};
+
+} // End of transport_catalogue
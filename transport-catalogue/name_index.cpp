@@ -0,0 +1,187 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+using namespace std;
+
+namespace {
+
+// Хеш строки (FNV-1a с перемешиванием битов). Строка проходится один раз,
+// дальше все слоты вычисляются из этого значения
+uint64_t HashName(string_view key) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const char c : key) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// Получение нового хеша из хеша строки и смещения корзины
+uint64_t MixHash(uint64_t hash, uint32_t seed) {
+	uint64_t value = hash ^ (seed * 0x9e3779b97f4a7c15ull);
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ull;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebull;
+	value ^= value >> 31;
+	return value;
+}
+
+} // End of namespace
+
+// Построение по набору уникальных названий (алгоритм "hash and displace").
+// Названия раскладываются по корзинам, затем для каждой корзины, начиная с самых
+// больших, подбирается смещение, при котором все ее названия попадают в свободные слоты.
+// Корзины из одного названия занимают оставшиеся слоты напрямую
+PerfectHash::PerfectHash(const vector<string_view>& keys) {
+	const size_t key_count = keys.size();
+	if (key_count == 0) {
+		return;
+	}
+
+	if (key_count > static_cast<size_t>(numeric_limits<int32_t>::max())) {
+		throw invalid_argument("Too many names for perfect hash");
+	}
+
+	vector<uint64_t> hashes(key_count);
+	for (size_t i = 0; i < key_count; ++i) {
+		hashes[i] = HashName(keys[i]);
+	}
+
+	// Раскладка названий по корзинам
+	vector<vector<uint32_t>> buckets(key_count);
+	for (size_t i = 0; i < key_count; ++i) {
+		buckets[hashes[i] % key_count].push_back(static_cast<uint32_t>(i));
+	}
+
+	// Порядок обработки корзин - по убыванию размера
+	vector<size_t> order(key_count);
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+		return buckets[lhs].size() > buckets[rhs].size();
+	});
+
+	displacements_.assign(key_count, 0);
+	slots_.assign(key_count, 0);
+	vector<bool> taken(key_count, false);
+	vector<size_t> candidate_slots;
+
+	size_t pos = 0;
+	for (; pos < order.size() && buckets[order[pos]].size() > 1; ++pos) {
+		auto& bucket = buckets[order[pos]];
+
+		// Одинаковые хеши невозможно развести никаким смещением
+		sort(bucket.begin(), bucket.end(), [&hashes](uint32_t lhs, uint32_t rhs) {
+			return hashes[lhs] < hashes[rhs];
+		});
+		for (size_t i = 1; i < bucket.size(); ++i) {
+			if (hashes[bucket[i - 1]] == hashes[bucket[i]]) {
+				throw invalid_argument("Duplicate name in perfect hash: " + string(keys[bucket[i]]));
+			}
+		}
+
+		// Подбор смещения, при котором все названия корзины попадают в свободные слоты
+		for (uint32_t seed = 1;; ++seed) {
+			candidate_slots.clear();
+			for (uint32_t key : bucket) {
+				size_t slot = MixHash(hashes[key], seed) % key_count;
+				if (taken[slot] || find(candidate_slots.begin(), candidate_slots.end(), slot) != candidate_slots.end()) {
+					break;
+				}
+				candidate_slots.push_back(slot);
+			}
+
+			if (candidate_slots.size() == bucket.size()) {
+				displacements_[order[pos]] = static_cast<int32_t>(seed);
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < bucket.size(); ++i) {
+			taken[candidate_slots[i]] = true;
+			slots_[candidate_slots[i]] = bucket[i];
+		}
+	}
+
+	// Корзины из одного названия занимают свободные слоты по порядку
+	size_t free_slot = 0;
+	for (; pos < order.size() && buckets[order[pos]].size() == 1; ++pos) {
+		while (taken[free_slot]) {
+			++free_slot;
+		}
+		taken[free_slot] = true;
+		slots_[free_slot] = buckets[order[pos]][0];
+		displacements_[order[pos]] = -static_cast<int32_t>(free_slot) - 1;
+	}
+}
+
+// Построение по набору уникальных названий с заданными номерами
+PerfectHash::PerfectHash(const vector<string_view>& keys, const vector<uint32_t>& ids)
+	: PerfectHash(keys) {
+	if (keys.size() != ids.size()) {
+		throw invalid_argument("Incorrect perfect hash ids");
+	}
+
+	for (uint32_t& slot : slots_) {
+		slot = ids[slot];
+	}
+}
+
+// Восстановление из сохраненных таблиц
+PerfectHash::PerfectHash(vector<int32_t> displacements, vector<uint32_t> slots)
+	: displacements_(move(displacements))
+	, slots_(move(slots)) {
+	if (displacements_.empty() != slots_.empty()) {
+		throw invalid_argument("Incorrect perfect hash tables");
+	}
+}
+
+// Поиск номера названия. Возвращает nullopt только для пустого набора
+optional<uint32_t> PerfectHash::Find(string_view key) const {
+	if (slots_.empty()) {
+		return nullopt;
+	}
+
+	const uint64_t hash = HashName(key);
+	const int32_t displacement = displacements_[hash % displacements_.size()];
+
+	const size_t slot = displacement < 0
+		? static_cast<size_t>(-(displacement + 1))
+		: MixHash(hash, static_cast<uint32_t>(displacement)) % slots_.size();
+
+	// Проверка на случай поврежденных таблиц из базы
+	if (slot >= slots_.size()) {
+		return nullopt;
+	}
+
+	return slots_[slot];
+}
+
+// Количество названий в наборе
+size_t PerfectHash::Size() const {
+	return slots_.size();
+}
+
+// Расход памяти на таблицы
+memory_usage::Usage PerfectHash::GetMemoryUsage() const {
+	return { slots_.size(), memory_usage::Bytes(displacements_) + memory_usage::Bytes(slots_) };
+}
+
+const vector<int32_t>& PerfectHash::GetDisplacements() const {
+	return displacements_;
+}
+
+const vector<uint32_t>& PerfectHash::GetSlots() const {
+	return slots_;
+}
+
+} // End of transport_catalogue
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Минимальная совершенная хеш-функция над фиксированным набором названий.
+// Каждому названию из набора соответствует свой слот без коллизий, поэтому поиск
+// выполняется одним вычислением хеша строки и одним обращением к таблице.
+// Для названий не из набора возвращается произвольный номер, поэтому найденный
+// элемент нужно сверять по названию
+class PerfectHash {
+public:
+	PerfectHash() = default;
+
+	// Построение по набору уникальных названий. Название keys[i] получает номер i
+	explicit PerfectHash(const std::vector<std::string_view>& keys);
+
+	// Построение по набору уникальных названий. Название keys[i] получает номер ids[i]
+	PerfectHash(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& ids);
+
+	// Восстановление из сохраненных таблиц
+	PerfectHash(std::vector<int32_t> displacements, std::vector<uint32_t> slots);
+
+	// Поиск номера названия. Возвращает nullopt только для пустого набора
+	std::optional<uint32_t> Find(std::string_view key) const;
+
+	// Количество названий в наборе
+	size_t Size() const;
+
+	// Расход памяти на таблицы
+	memory_usage::Usage GetMemoryUsage() const;
+
+	// Таблицы для сохранения в базу
+	const std::vector<int32_t>& GetDisplacements() const;
+	const std::vector<uint32_t>& GetSlots() const;
+
+private:
+	// Смещения для корзин. Отрицательное значение -(slot + 1) задает слот напрямую
+	std::vector<int32_t> displacements_;
+
+	// Номера названий по слотам
+	std::vector<uint32_t> slots_;
+};
+
+// Индексы названий остановок и маршрутов, сохраняемые в базе.
+// Номер названия совпадает с порядком остановок и маршрутов в базе
+struct NameIndex {
+	PerfectHash stops;
+	PerfectHash buses;
+};
+
+} // End of transport_catalogue
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Количество потоков, которые выполняются одновременно. Не меньше одного
+inline size_t GetHardwareThreads() {
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Количество потоков для обработки chunk_count блоков. Запуск потока дороже обработки
+// нескольких легких блоков, поэтому на каждый поток приходится не меньше
+// min_chunks_per_thread блоков, а небольшие объемы обрабатываются в вызывающем потоке
+inline size_t GetThreadCount(size_t chunk_count, size_t min_chunks_per_thread) {
+	return std::max<size_t>(1, std::min(chunk_count / std::max<size_t>(1, min_chunks_per_thread), GetHardwareThreads()));
+}
+
+// Обработка count элементов блоками по chunk_size. Блоки раздаются потокам по мере
+// освобождения, результат process_chunk(begin, end) для блока с номером i записывается
+// в позицию i. Исключение из блока передается вызывающему после завершения всех
+// потоков, из нескольких - первое по номеру блока
+template <typename Result, typename Function>
+std::vector<Result> MapChunks(size_t count, size_t chunk_size, size_t min_chunks_per_thread, Function process_chunk) {
+	const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+	std::vector<Result> result(chunk_count);
+	std::vector<std::exception_ptr> errors(chunk_count);
+
+	std::atomic<size_t> next_chunk = 0;
+	auto worker = [&] {
+		for (size_t chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++) {
+			const size_t begin = chunk * chunk_size;
+			const size_t end = std::min(count, begin + chunk_size);
+			try {
+				result[chunk] = process_chunk(begin, end);
+			}
+			catch (...) {
+				errors[chunk] = std::current_exception();
+			}
+		}
+	};
+
+	const size_t thread_count = GetThreadCount(chunk_count, min_chunks_per_thread);
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < thread_count; ++i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+
+	for (const std::exception_ptr& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	return result;
+}
+
+} // End of parallel
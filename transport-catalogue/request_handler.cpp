@@ -1,6 +1,9 @@
 ﻿#include "request_handler.h"
 #include "json_builder.h"
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
 #include <string_view>
 #include <stdexcept>
 
@@ -71,6 +74,194 @@ json::Node GenerateBusResult(int id, std::optional<BusStat> bus_info) {
 	return result.Build();
 }
 
+json::Node GenerateNearestStopsResult(int id, const vector<NearestStop>& stops) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id)
+		.Key("stops"s).StartArray();
+
+	for (const NearestStop& stop : stops) {
+		result.StartDict()
+			.Key("name"s).Value(string(stop.stop->name_))
+			.Key("distance"s).Value(stop.distance)
+			.EndDict();
+	}
+
+	result.EndArray().EndDict();
+
+	return result.Build();
+}
+
+json::Node GenerateAutocompleteResult(int id, const vector<string_view>& names) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id)
+		.Key("items"s).StartArray();
+
+	for (string_view name : names) {
+		result.Value(string(name));
+	}
+
+	result.EndArray().EndDict();
+
+	return result.Build();
+}
+
+json::Node GenerateDirectBusesResult(int id, const optional<vector<DirectBus>>& direct_buses,
+	const transport_router::TransportRouter& transport_router) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id);
+
+	if (!direct_buses) {
+		result.Key("error_message"s).Value("not found"s);
+	}
+	else {
+		result.Key("buses"s).StartArray();
+
+		for (const DirectBus& direct_bus : *direct_buses) {
+			result.StartDict()
+				.Key("bus"s).Value(string(direct_bus.bus->name_))
+				.Key("span_count"s).Value(direct_bus.span_count)
+				.Key("time"s).Value(transport_router.GetRideTime(direct_bus.distance))
+				.EndDict();
+		}
+
+		result.EndArray();
+	}
+
+	result.EndDict();
+
+	return result.Build();
+}
+
+// Число для вывода. Значения, которые не помещаются в int, выводятся как double
+json::Node SizeNode(size_t value) {
+	if (value <= static_cast<size_t>(numeric_limits<int>::max())) {
+		return static_cast<int>(value);
+	}
+	return static_cast<double>(value);
+}
+
+json::Dict GenerateDistribution(const analytics::Distribution& distribution) {
+	return json::Dict{
+		{ "min"s, distribution.min },
+		{ "max"s, distribution.max },
+		{ "mean"s, distribution.mean },
+		{ "median"s, distribution.median },
+		{ "p90"s, distribution.p90 }
+	};
+}
+
+json::Array GenerateRanking(const vector<analytics::RankedItem>& items) {
+	json::Array result;
+	result.reserve(items.size());
+
+	for (const analytics::RankedItem& item : items) {
+		result.push_back(json::Dict{ { "name"s, string(item.name) }, { "value"s, item.value } });
+	}
+
+	return result;
+}
+
+json::Node GenerateAnalyticsResult(int id, const analytics::NetworkStats& stats) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id)
+		.Key("bus_count"s).Value(SizeNode(stats.bus_count).GetValue())
+		.Key("stop_count"s).Value(SizeNode(stats.stop_count).GetValue())
+		.Key("total_route_length"s).Value(SizeNode(static_cast<size_t>(stats.total_route_length)).GetValue())
+		.Key("total_geo_length"s).Value(stats.total_geo_length)
+		.Key("total_stop_count"s).Value(SizeNode(static_cast<size_t>(stats.total_stop_count)).GetValue())
+		.Key("distributions"s).StartDict()
+			.Key("route_length"s).Value(GenerateDistribution(stats.route_length))
+			.Key("curvature"s).Value(GenerateDistribution(stats.curvature))
+			.Key("stop_count"s).Value(GenerateDistribution(stats.stop_count_per_bus))
+			.Key("buses_per_stop"s).Value(GenerateDistribution(stats.buses_per_stop))
+		.EndDict()
+		.Key("top"s).StartDict()
+			.Key("longest_buses"s).Value(GenerateRanking(stats.longest_buses))
+			.Key("most_curved_buses"s).Value(GenerateRanking(stats.most_curved_buses))
+			.Key("busiest_buses"s).Value(GenerateRanking(stats.busiest_buses))
+			.Key("busiest_stops"s).Value(GenerateRanking(stats.busiest_stops))
+		.EndDict()
+		.EndDict();
+
+	return result.Build();
+}
+
+json::Node GenerateStatsResult(int id, const map<string, memory_usage::Report>& components) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id)
+		.Key("components"s).StartDict();
+
+	size_t total_bytes = 0;
+
+	for (const auto& [component_name, report] : components) {
+		const size_t component_bytes = memory_usage::TotalBytes(report);
+		total_bytes += component_bytes;
+
+		result.Key(component_name).StartDict()
+			.Key("bytes"s).Value(SizeNode(component_bytes).GetValue())
+			.Key("parts"s).StartDict();
+
+		for (const auto& [part_name, usage] : report) {
+			result.Key(part_name).StartDict()
+				.Key("count"s).Value(SizeNode(usage.count).GetValue())
+				.Key("bytes"s).Value(SizeNode(usage.bytes).GetValue())
+				.EndDict();
+		}
+
+		result.EndDict().EndDict();
+	}
+
+	result.EndDict()
+		.Key("total_bytes"s).Value(SizeNode(total_bytes).GetValue())
+		.EndDict();
+
+	return result.Build();
+}
+
+// Ответ на запрос изменения базы: названия измененных маршрутов по алфавиту
+json::Node GenerateChangeResult(int id, const optional<vector<const Bus*>>& changed_buses) {
+	// Узел для возврата
+	json::Builder result{};
+
+	result.StartDict()
+		.Key("request_id"s).Value(id);
+
+	if (!changed_buses) {
+		result.Key("error_message"s).Value("not found"s);
+	}
+	else {
+		set<string_view> bus_names;
+		for (const Bus* bus : *changed_buses) {
+			bus_names.insert(bus->name_);
+		}
+
+		result.Key("changed_buses"s).StartArray();
+		for (string_view bus_name : bus_names) {
+			result.Value(string(bus_name));
+		}
+		result.EndArray();
+	}
+
+	result.EndDict();
+
+	return result.Build();
+}
+
 json::Node GenerateMapResult(int id, svg::Document map) {
 	// Рендер карты в строку
 	ostringstream strm;
@@ -97,7 +288,7 @@ json::Node GenerateRouteList(int id, const transport_router::RouteResponce& rout
 
 			wait_node.StartDict()
 				.Key("type"s).Value("Wait"s)
-				.Key("stop_name"s).Value(item.stop_name)
+				.Key("stop_name"s).Value(string(item.stop_name))
 				.Key("time"s).Value(route_responce.bus_wait_time)
 				.EndDict();
 
@@ -108,7 +299,7 @@ json::Node GenerateRouteList(int id, const transport_router::RouteResponce& rout
 
 			bus_node.StartDict()
 				.Key("type"s).Value("Bus"s)
-				.Key("bus"s).Value(item.bus_name)
+				.Key("bus"s).Value(string(item.bus_name))
 				.Key("span_count"s).Value(item.span_count)
 				.Key("time"s).Value(item.time)
 				.EndDict();
@@ -116,7 +307,7 @@ json::Node GenerateRouteList(int id, const transport_router::RouteResponce& rout
 			items_list.push_back(bus_node.Build());
 		}
 		else {
-			throw logic_error("Unknown rote list item type"s);
+			throw logic_error("Unknown route list item type"s);
 		}
 	}
 
@@ -147,9 +338,74 @@ json::Node GenerateRouteResult(int id, optional<transport_router::RouteResponce>
 	}
 }
 
+// Разбиение ответа, построенного с номером запроса 0, на части до и после номера
+ResponseTemplate MakeResponseTemplate(const json::Node& response) {
+	ostringstream strm;
+	json::Print(json::Document(response), strm);
+	const string text = strm.str();
+
+	// Кавычки внутри строковых значений экранируются, поэтому ключ находится однозначно
+	static const string_view marker = "\"request_id\": "sv;
+	const size_t pos = text.find(marker);
+	if (pos == string::npos || text.compare(pos + marker.size(), 1, "0"sv) != 0) {
+		throw logic_error("Response without request_id"s);
+	}
+
+	return { text.substr(0, pos + marker.size()), text.substr(pos + marker.size() + 1) };
+}
+
+// Вставка номера запроса в готовый ответ
+json::Node SpliceResponse(int id, const ResponseTemplate& response) {
+	string id_text = to_string(id);
+
+	string text;
+	text.reserve(response.head.size() + id_text.size() + response.tail.size());
+	text.append(response.head).append(id_text).append(response.tail);
+
+	return json::RawValue{ move(text) };
+}
 
 } // End of details
 
+// Формирование ответов на запросы Stop и Bus для всех остановок и маршрутов каталога
+MaterializedResponses MaterializeResponses(const TransportCatalogue& catalogue) {
+	MaterializedResponses result;
+
+	const vector<const Stop*> stops = catalogue.GetStopList();
+	result.stops.resize(stops.size());
+	for (const Stop* stop : stops) {
+		result.stops.at(stop->id_) = details::MakeResponseTemplate(
+			details::GenerateStopResult(0, catalogue.GetBusesToStop(stop->name_)));
+	}
+
+	const vector<const Bus*> buses = catalogue.GetBusList();
+	result.buses.resize(buses.size());
+	for (const Bus* bus : buses) {
+		result.buses.at(bus->id_) = details::MakeResponseTemplate(
+			details::GenerateBusResult(0, catalogue.GetBusInfo(bus->name_)));
+	}
+
+	return result;
+}
+
+// Готовый ответ на запрос Stop из базы
+const ResponseTemplate* RequestHandler::FindStopResponse(string_view stop_name) const {
+	const Stop* stop = catalogue_.GetStopByName(stop_name);
+	if (stop == nullptr || stop->id_ >= responses_.stops.size() || responses_.stops[stop->id_].head.empty()) {
+		return nullptr;
+	}
+	return &responses_.stops[stop->id_];
+}
+
+// Готовый ответ на запрос Bus из базы
+const ResponseTemplate* RequestHandler::FindBusResponse(string_view bus_name) const {
+	const Bus* bus = catalogue_.GetBusByName(bus_name);
+	if (bus == nullptr || bus->id_ >= responses_.buses.size() || responses_.buses[bus->id_].head.empty()) {
+		return nullptr;
+	}
+	return &responses_.buses[bus->id_];
+}
+
 // Возвращает маршруты, проходящие через остановку (запрос Stop)
 const set<const Bus*>* RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
 	return catalogue_.GetBusesToStop(stop_name);
@@ -160,17 +416,89 @@ std::optional<BusStat> RequestHandler::GetBusInfo(const std::string_view& bus_na
 	return catalogue_.GetBusInfo(bus_name);
 }
 
+// Возвращает ближайшие к точке остановки (запрос NearestStops)
+vector<NearestStop> RequestHandler::GetNearestStops(geo::Coordinates location, size_t count) const {
+	return catalogue_.GetNearestStops(location, count);
+}
+
+// Возвращает не более count названий остановок или маршрутов, начинающихся с prefix (запрос Autocomplete)
+vector<string_view> RequestHandler::Autocomplete(AutocompleteKind kind, string_view prefix, size_t count) const {
+	vector<string_view> result;
+
+	switch (kind) {
+	case AutocompleteKind::STOP:
+		for (const Stop* stop : catalogue_.SearchStops(prefix, count)) {
+			result.push_back(stop->name_);
+		}
+		break;
+	case AutocompleteKind::BUS:
+		for (const Bus* bus : catalogue_.SearchBuses(prefix, count)) {
+			result.push_back(bus->name_);
+		}
+		break;
+	}
+
+	return result;
+}
+
 // Получение маршрута между остановками
 optional<transport_router::RouteResponce> RequestHandler::GetRoute(std::string_view stop_from, std::string_view stop_to) const {
-	// Получение свойст движения автобусов, для расчета времени маршрута
-	const transport_router::RoutingSettings routing_settings = transport_router_.GetRoutingSettings();
-
 	// Получение VertexId остановок
 	graph::VertexId vertex_id_from = transport_router_.GetVertexId(stop_from);
 	graph::VertexId vertex_id_to = transport_router_.GetVertexId(stop_to);
 
 	// Возврат информации о кратчайшем маршруте из маршрутизатора
-	optional<graph::Router<double>::RouteInfo> route_info = router_.BuildRoute(vertex_id_from, vertex_id_to);
+	return MakeRouteResponce(router_.BuildRoute(vertex_id_from, vertex_id_to));
+}
+
+// Получение маршрута между остановками в сценарии с закрытыми остановками и маршрутами
+optional<transport_router::RouteResponce> RequestHandler::GetRoute(string_view stop_from, string_view stop_to,
+	const Closures& closures) const {
+	graph::VertexId vertex_id_from = transport_router_.GetVertexId(stop_from);
+	graph::VertexId vertex_id_to = transport_router_.GetVertexId(stop_to);
+
+	// Матрица маршрутизатора построена без учета сценария, поэтому путь ищется по графу
+	return MakeRouteResponce(transport_router_.BuildRoute(vertex_id_from, vertex_id_to, closures));
+}
+
+// Информация о маршруте в сценарии с закрытыми остановками и маршрутами
+optional<BusStat> RequestHandler::GetBusInfo(const string_view& bus_name, const Closures& closures) const {
+	return catalogue_.GetBusInfo(bus_name, closures);
+}
+
+// Информация о маршруте с учетом сценария запроса
+optional<BusStat> RequestHandler::GetBusInfo(const BusRequest& request) const {
+	if (optional<Closures> closures = GetClosures(request.closed)) {
+		return GetBusInfo(request.name, *closures);
+	}
+	return GetBusInfo(request.name);
+}
+
+// Маршрут между остановками с учетом сценария запроса
+optional<transport_router::RouteResponce> RequestHandler::GetRoute(const RouteRequest& request) const {
+	if (optional<Closures> closures = GetClosures(request.closed)) {
+		return GetRoute(request.from, request.to, *closures);
+	}
+	return GetRoute(request.from, request.to);
+}
+
+double RequestHandler::GetRideTime(double distance) const {
+	return transport_router_.GetRideTime(distance);
+}
+
+// Сценарий запроса по его полям closed_stops и closed_buses
+optional<Closures> RequestHandler::GetClosures(const optional<ClosedNames>& closed) const {
+	if (!closed) {
+		return nullopt;
+	}
+	return catalogue_.MakeClosures(closed->stops, closed->buses);
+}
+
+// Ответ на запрос Route по найденному пути в графе
+optional<transport_router::RouteResponce> RequestHandler::MakeRouteResponce(
+	const optional<graph::Router<double>::RouteInfo>& route_info) const {
+	// Получение свойст движения автобусов, для расчета времени маршрута
+	const transport_router::RoutingSettings routing_settings = transport_router_.GetRoutingSettings();
 
 	if (route_info == nullopt) {
 		return nullopt;
@@ -213,55 +541,124 @@ optional<transport_router::RouteResponce> RequestHandler::GetRoute(std::string_v
 	return result;
 }
 
+// Возвращает маршруты без пересадок между остановками (запрос DirectBuses)
+optional<vector<DirectBus>> RequestHandler::GetDirectBuses(string_view stop_from, string_view stop_to) const {
+	return catalogue_.GetDirectBuses(stop_from, stop_to);
+}
+
+// Сводная статистика сети с рейтингами из top_count элементов (запрос Analytics)
+analytics::NetworkStats RequestHandler::GetNetworkStats(size_t top_count) const {
+	return analytics::ComputeNetworkStats(catalogue_, top_count);
+}
+
+// Расход памяти по компонентам базы (запрос Stats)
+map<string, memory_usage::Report> RequestHandler::GetMemoryStats() const {
+	map<string, memory_usage::Report> result;
+
+	result["catalogue"s] = catalogue_.GetMemoryUsage();
+	result["transport_router"s] = transport_router_.GetMemoryUsage();
+	result["router"s]["routes_matrix"s] = router_.GetMemoryUsage();
+
+	// Готовые ответы из базы
+	for (const auto& [part_name, responses] : { pair{ "stop_responses"s, &responses_.stops }, pair{ "bus_responses"s, &responses_.buses } }) {
+		memory_usage::Usage& usage = result["responses"s][part_name] = memory_usage::Of(*responses);
+		for (const ResponseTemplate& response : *responses) {
+			usage.bytes += response.head.capacity() + response.tail.capacity();
+		}
+	}
+
+	return result;
+}
+
 // Этот метод будет нужен в следующей части итогового проекта
 svg::Document RequestHandler::RenderMap() const{
 	// Получение списка маршрутов из справочника
 	const auto bus_list = catalogue_.GetBusList();
 
 	// Передача данных и генерация документа с картой
-	svg::Document bus_map = renderer_.GenerateMap(bus_list);
+	svg::Document bus_map = renderer_.GenerateMap(bus_list, catalogue_.GetStopArrays());
 
 	return bus_map;
 }
 
 
-// Обработка списка запросов
- json::Document RequestHandler::GetJsonResponce(const std::deque<RequestInfo>& request_list) {
-	
-	// Создаем корневой массив для вывода
-	json::Array response_output;
-
-	response_output.reserve(request_list.size());
-
-	 
-	for (auto& request : request_list) {
-		string_view request_type = request.request_items.at("type"s);
-		if (request_type == "Stop"sv){
-			const auto buses_list = GetBusesByStop(request.request_items.at("name"s));
-			json::Node stop_result = details::GenerateStopResult(request.id, buses_list);
-			response_output.push_back(stop_result);
-		}
-		else if (request_type == "Bus"sv) {
-			auto bus_info = GetBusInfo(request.request_items.at("name"s));
-			json::Node bus_result = details::GenerateBusResult(request.id, bus_info);
-			response_output.push_back(bus_result);
+// Ответ на один запрос
+json::Node RequestHandler::GetResponse(const RequestInfo& request) {
+	switch (request.GetType()) {
+	case RequestType::STOP: {
+		const auto& stop = get<StopRequest>(request.fields);
+		if (const ResponseTemplate* response = FindStopResponse(stop.name)) {
+			return details::SpliceResponse(request.id, *response);
 		}
-		else if (request_type == "Route"sv) {
-			optional<transport_router::RouteResponce> route_result = GetRoute(request.request_items.at("from"s), request.request_items.at("to"s));
 
-			json::Node router_result = details::GenerateRouteResult(request.id, route_result);
-			response_output.push_back(router_result);
-		}
-		else if (request_type == "Map"sv) {
-			json::Node map_result = details::GenerateMapResult(request.id, RenderMap());
-			response_output.push_back(map_result);
+		const auto buses_list = GetBusesByStop(stop.name);
+		return details::GenerateStopResult(request.id, buses_list);
+	}
+	case RequestType::BUS: {
+		const auto& bus = get<BusRequest>(request.fields);
+
+		// Готовые ответы в базе построены без сценария
+		if (!bus.closed) {
+			if (const ResponseTemplate* response = FindBusResponse(bus.name)) {
+				return details::SpliceResponse(request.id, *response);
+			}
 		}
-		else {
-			throw logic_error("unknown request type"s);
+
+		return details::GenerateBusResult(request.id, GetBusInfo(bus));
+	}
+	case RequestType::ROUTE:
+		return details::GenerateRouteResult(request.id, GetRoute(get<RouteRequest>(request.fields)));
+	case RequestType::NEAREST_STOPS: {
+		const auto& nearest = get<NearestStopsRequest>(request.fields);
+		return details::GenerateNearestStopsResult(request.id, GetNearestStops(nearest.location, nearest.count));
+	}
+	case RequestType::AUTOCOMPLETE: {
+		const auto& autocomplete = get<AutocompleteRequest>(request.fields);
+		auto names = Autocomplete(autocomplete.kind, autocomplete.prefix, autocomplete.count);
+
+		return details::GenerateAutocompleteResult(request.id, names);
+	}
+	case RequestType::DIRECT_BUSES: {
+		const auto& direct = get<DirectBusesRequest>(request.fields);
+		auto direct_buses = GetDirectBuses(direct.from, direct.to);
+
+		return details::GenerateDirectBusesResult(request.id, direct_buses, transport_router_);
+	}
+	case RequestType::ANALYTICS:
+		return details::GenerateAnalyticsResult(request.id, GetNetworkStats(get<AnalyticsRequest>(request.fields).count));
+	case RequestType::STATS:
+		return details::GenerateStatsResult(request.id, GetMemoryStats());
+	case RequestType::MAP:
+		return details::GenerateMapResult(request.id, RenderMap());
+	case RequestType::REMOVE_STOP:
+		return details::GenerateChangeResult(request.id, snapshot_->RemoveStop(get<RemoveStopRequest>(request.fields).name));
+	case RequestType::REMOVE_BUS: {
+		optional<vector<const Bus*>> changed_buses;
+		if (const Bus* bus = snapshot_->RemoveBus(get<RemoveBusRequest>(request.fields).name)) {
+			changed_buses = vector<const Bus*>{ bus };
 		}
+		return details::GenerateChangeResult(request.id, changed_buses);
+	}
+	case RequestType::SET_DISTANCE: {
+		const auto& distance = get<SetDistanceRequest>(request.fields);
+		return details::GenerateChangeResult(request.id,
+			snapshot_->SetDistance({ distance.distance, distance.from, distance.to }));
+	}
+	}
+
+	throw logic_error("unknown request type"s);
+}
+
+// Обработка списка запросов с выводом каждого ответа сразу после его формирования.
+// Ответы не накапливаются, поэтому расход памяти не зависит от количества запросов
+void RequestHandler::WriteJsonResponce(const std::deque<RequestInfo>& request_list, std::ostream& output) {
+	json::ArrayWriter writer(output);
+
+	for (const RequestInfo& request : request_list) {
+		writer.Write(GetResponse(request));
 	}
 
-	return json::Document(json::Builder{}.Value(response_output).Build());
+	writer.Finish();
 }
 
 } // End of request_handler
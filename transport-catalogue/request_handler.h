@@ -1,11 +1,14 @@
 ﻿#pragma once
 
+#include "analytics.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "json.h"
 #include "transport_router.h"
+#include "snapshot.h"
 
 #include <deque>
+#include <map>
 #include <optional>
 #include <set>
 
@@ -13,16 +16,16 @@ namespace request_handler{
 
  class RequestHandler {
  public:
-     RequestHandler(
-         transport_catalogue::TransportCatalogue& catalogue,
-         map_renderer::MapRenderer& renderer,
-         transport_router::TransportRouter& transport_router,
-         graph::Router<double>& router
-     )
-         : catalogue_(catalogue)
-         , renderer_(renderer)
-         , transport_router_(transport_router)
-         , router_(router) {}
+     // Обработчик удерживает снимок базы, поэтому публикация нового снимка
+     // не влияет на уже начатую обработку запросов. Запросы изменения базы
+     // меняют этот снимок
+     explicit RequestHandler(std::shared_ptr<snapshot::Snapshot> snapshot)
+         : snapshot_(std::move(snapshot))
+         , catalogue_(snapshot_->GetCatalogue())
+         , renderer_(snapshot_->GetRenderer())
+         , transport_router_(snapshot_->GetTransportRouter())
+         , router_(snapshot_->GetRouter())
+         , responses_(snapshot_->GetResponses()) {}
 
      // Возвращает информацию о маршруте (запрос Bus)
      std::optional<transport_catalogue::BusStat> GetBusInfo(const std::string_view& bus_name) const;
@@ -30,22 +33,73 @@ namespace request_handler{
      // Возвращает маршруты, проходящие через остановку (запрос Stop)
      const std::set<const transport_catalogue::Bus*>* GetBusesByStop(const std::string_view& stop_name) const;
 
+     // Возвращает ближайшие к точке остановки (запрос NearestStops)
+     std::vector<transport_catalogue::NearestStop> GetNearestStops(geo::Coordinates location, size_t count) const;
+
+     // Возвращает не более count названий остановок или маршрутов, начинающихся с prefix (запрос Autocomplete)
+     std::vector<std::string_view> Autocomplete(transport_catalogue::AutocompleteKind kind, std::string_view prefix, size_t count) const;
+
+     // Возвращает маршруты без пересадок между остановками (запрос DirectBuses)
+     std::optional<std::vector<transport_catalogue::DirectBus>> GetDirectBuses(std::string_view stop_from, std::string_view stop_to) const;
+
+     // Сводная статистика сети с рейтингами из top_count элементов (запрос Analytics)
+     analytics::NetworkStats GetNetworkStats(size_t top_count) const;
+
+     // Расход памяти по компонентам базы (запрос Stats)
+     std::map<std::string, memory_usage::Report> GetMemoryStats() const;
+
      // Этот метод будет нужен в следующей части итогового проекта
      svg::Document RenderMap() const;
 
      // Получение маршрута между остановками
      std::optional<transport_router::RouteResponce> GetRoute(std::string_view stop_from, std::string_view stop_to) const;
 
-     // Обработка списка запросов
-     json::Document GetJsonResponce(const std::deque<transport_catalogue::RequestInfo>& request_list);
+     // Запросы Bus и Route в сценарии с закрытыми остановками и маршрутами
+     std::optional<transport_catalogue::BusStat> GetBusInfo(const std::string_view& bus_name,
+         const transport_catalogue::Closures& closures) const;
+     std::optional<transport_router::RouteResponce> GetRoute(std::string_view stop_from, std::string_view stop_to,
+         const transport_catalogue::Closures& closures) const;
+
+     // Запросы Bus и Route с учетом сценария, если он задан в запросе
+     std::optional<transport_catalogue::BusStat> GetBusInfo(const transport_catalogue::BusRequest& request) const;
+     std::optional<transport_router::RouteResponce> GetRoute(const transport_catalogue::RouteRequest& request) const;
+
+     // Время проезда автобусом расстояния distance в минутах (для ответа DirectBuses)
+     double GetRideTime(double distance) const;
+
+     // Ответ на один запрос
+     json::Node GetResponse(const transport_catalogue::RequestInfo& request);
+
+     // Обработка списка запросов с выводом каждого ответа в output сразу после его формирования.
+     // Вывод совпадает с выводом json::Print для массива всех ответов
+     void WriteJsonResponce(const std::deque<transport_catalogue::RequestInfo>& request_list, std::ostream& output);
 
  private:
+     // Снимок базы, из которого взяты объекты ниже
+     std::shared_ptr<snapshot::Snapshot> snapshot_;
+
      // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
      const transport_catalogue::TransportCatalogue& catalogue_;
      const map_renderer::MapRenderer& renderer_;
      const transport_router::TransportRouter& transport_router_;
-     const graph::Router<double> router_;
+     const graph::Router<double>& router_;
+     const transport_catalogue::MaterializedResponses& responses_;
+
+     // Сценарий запроса по его полям closed_stops и closed_buses. nullopt, если их нет
+     std::optional<transport_catalogue::Closures> GetClosures(const std::optional<transport_catalogue::ClosedNames>& closed) const;
+
+     // Ответ на запрос Route по найденному пути в графе
+     std::optional<transport_router::RouteResponce> MakeRouteResponce(
+         const std::optional<graph::Router<double>::RouteInfo>& route_info) const;
+
+     // Готовый ответ на запрос Stop или Bus из базы. nullptr, если его нет
+     const transport_catalogue::ResponseTemplate* FindStopResponse(std::string_view stop_name) const;
+     const transport_catalogue::ResponseTemplate* FindBusResponse(std::string_view bus_name) const;
  };
 
+ // Формирование ответов на запросы Stop и Bus для всех остановок и маршрутов каталога.
+ // Ответы сохраняются в базу и при обработке запросов только дополняются номером запроса
+ transport_catalogue::MaterializedResponses MaterializeResponses(const transport_catalogue::TransportCatalogue& catalogue);
+
 
  } // End of request_handler
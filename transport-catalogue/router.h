@@ -1,12 +1,15 @@
 ﻿#pragma once
 
 #include "graph.h"
+#include "memory_usage.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <functional>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -35,6 +38,22 @@ public:
     // Возвращает общую длительности и список ребер для оптимального маршрута
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Обновление матрицы после изменения графа: ребра removed_edges уже исключены из графа,
+    // ребра added_edges добавлены, вершины не менялись. Строки, пути которых проходили
+    // по исключенным ребрам, строятся заново поиском от вершины отправления, а остальные
+    // строки только сокращаются через добавленные ребра
+    void UpdateEdges(const std::vector<EdgeId>& removed_edges, const std::vector<EdgeId>& added_edges);
+
+    // Расход памяти на матрицу маршрутов. Количество - число ячеек матрицы
+    memory_usage::Usage GetMemoryUsage() const {
+        memory_usage::Usage result{ 0, memory_usage::Bytes(routes_internal_data_) };
+        for (const auto& row : routes_internal_data_) {
+            result.count += row.size();
+            result.bytes += memory_usage::Bytes(row);
+        }
+        return result;
+    }
+
 private:
     struct RouteInternalData {
         Weight weight;
@@ -108,6 +127,81 @@ private:
         }
     }
 
+    // Построение строки матрицы для вершины отправления алгоритмом Дейкстры по текущему графу
+    void BuildRoutesFromVertex(VertexId vertex_from) {
+        auto& routes = routes_internal_data_[vertex_from];
+        std::fill(routes.begin(), routes.end(), std::nullopt);
+        routes[vertex_from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        queue.emplace(ZERO_WEIGHT, vertex_from);
+
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+
+            // Устаревшая запись очереди
+            if (weight > routes[vertex]->weight) {
+                continue;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight next_weight = weight + edge.weight;
+
+                auto& route = routes[edge.to];
+                if (!route || next_weight < route->weight) {
+                    route = RouteInternalData{next_weight, edge_id};
+                    queue.emplace(next_weight, edge.to);
+                }
+            }
+        }
+    }
+
+    // Сокращение путей всех строк матрицы через новые ребра, выходящие из вершины
+    // vertex_through. Кратчайший путь проходит вершину один раз, поэтому использует
+    // не больше одного из этих ребер
+    void RelaxRoutesThroughNewEdges(size_t vertex_count, VertexId vertex_through,
+                                    const std::vector<EdgeId>& new_edges) {
+        // Лучшие пути от vertex_through до каждой вершины, начинающиеся с нового ребра
+        std::vector<std::optional<RouteInternalData>> routes_through(vertex_count);
+        for (const EdgeId edge_id : new_edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                const auto& route_to = routes_internal_data_[edge.to][vertex_to];
+                if (!route_to) {
+                    continue;
+                }
+
+                const Weight weight = edge.weight + route_to->weight;
+                auto& route_through = routes_through[vertex_to];
+                if (!route_through || weight < route_through->weight) {
+                    route_through = RouteInternalData{
+                        weight, route_to->prev_edge ? route_to->prev_edge : edge_id};
+                }
+            }
+        }
+
+        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            // Копия: ячейка до vertex_through не сокращается, но строка меняется
+            const auto route_from = routes_internal_data_[vertex_from][vertex_through];
+            if (!route_from) {
+                continue;
+            }
+
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                if (const auto& route_to = routes_through[vertex_to]) {
+                    RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+                }
+            }
+        }
+    }
+
     // Постоянная для обозначения пустого веса ребра
     static constexpr Weight ZERO_WEIGHT{};
 
@@ -160,4 +254,99 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight>
+void Router<Weight>::UpdateEdges(const std::vector<EdgeId>& removed_edges,
+                                 const std::vector<EdgeId>& added_edges) {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    // Путь строки состоит из последних ребер путей до своих вершин, поэтому
+    // исключенные ребра касаются только строк, где они последние в пути до вершины
+    if (!removed_edges.empty()) {
+        std::vector<bool> is_removed(graph_.GetEdgeCount());
+        for (const EdgeId edge_id : removed_edges) {
+            is_removed.at(edge_id) = true;
+        }
+
+        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            const auto& routes = routes_internal_data_[vertex_from];
+            const bool uses_removed = std::any_of(routes.begin(), routes.end(), [&is_removed](const auto& route) {
+                return route && route->prev_edge && is_removed[*route->prev_edge];
+            });
+            if (uses_removed) {
+                BuildRoutesFromVertex(vertex_from);
+            }
+        }
+    }
+
+    // Построенные заново строки уже учитывают новые ребра, а пути остальных строк
+    // сокращаются через новые ребра каждой начальной вершины по очереди
+    std::unordered_map<VertexId, std::vector<EdgeId>> new_edges;
+    for (const EdgeId edge_id : added_edges) {
+        new_edges[graph_.GetEdge(edge_id).from].push_back(edge_id);
+    }
+
+    for (const auto& [vertex_through, edges] : new_edges) {
+        RelaxRoutesThroughNewEdges(vertex_count, vertex_through, edges);
+    }
+}
+
+// Поиск кратчайшего маршрута алгоритмом Дейкстры без матрицы маршрутов.
+// Ребра, для которых edge_allowed возвращает false, не используются. Граф не меняется,
+// поэтому поиск можно выполнять по общему графу с разными наборами исключенных ребер
+template <typename Weight, typename EdgePredicate>
+std::optional<typename Router<Weight>::RouteInfo> BuildRouteFiltered(
+    const DirectedWeightedGraph<Weight>& graph, VertexId from, VertexId to, EdgePredicate edge_allowed) {
+    const size_t vertex_count = graph.GetVertexCount();
+
+    // Лучшие найденные веса и последние ребра путей до вершин
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    weights.at(from) = Weight{};
+    queue.emplace(Weight{}, from);
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+
+        // Устаревшая запись очереди
+        if (weight > *weights[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            if (!edge_allowed(edge_id)) {
+                continue;
+            }
+
+            const auto& edge = graph.GetEdge(edge_id);
+            const Weight next_weight = weight + edge.weight;
+            if (!weights[edge.to] || next_weight < *weights[edge.to]) {
+                weights[edge.to] = next_weight;
+                prev_edges[edge.to] = edge_id;
+                queue.emplace(next_weight, edge.to);
+            }
+        }
+    }
+
+    if (!weights.at(to)) {
+        return std::nullopt;
+    }
+
+    // Восстановление списка ребер от конечной вершины
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = to; vertex != from; vertex = graph.GetEdge(*prev_edges[vertex]).from) {
+        edges.push_back(*prev_edges[vertex]);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return typename Router<Weight>::RouteInfo{ *weights[to], std::move(edges) };
+}
+
 }  // namespace graph
\ No newline at end of file
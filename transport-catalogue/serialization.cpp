@@ -178,6 +178,61 @@ std::deque<transport_catalogue::BusToAdd> DeserialiseBuses(const serialization::
 	return result;
 }
 
+serialization::NameIndex SerialiseNameIndex(const transport_catalogue::PerfectHash& index) {
+	serialization::NameIndex result;
+
+	for (int32_t displacement : index.GetDisplacements()) {
+		result.add_displacements(displacement);
+	}
+
+	for (uint32_t slot : index.GetSlots()) {
+		result.add_slots(slot);
+	}
+
+	return result;
+}
+
+template <typename Container>
+transport_catalogue::PerfectHash BuildNameIndex(const Container& items) {
+	std::vector<std::string_view> names;
+	names.reserve(items.size());
+
+	for (auto& item : items) {
+		names.push_back(item.name);
+	}
+
+	return transport_catalogue::PerfectHash(names);
+}
+
+transport_catalogue::PerfectHash DeserialiseNameIndex(const serialization::NameIndex& index) {
+	return transport_catalogue::PerfectHash(
+		std::vector<int32_t>(index.displacements().begin(), index.displacements().end()),
+		std::vector<uint32_t>(index.slots().begin(), index.slots().end()));
+}
+
+void SerialiseResponses(const std::vector<transport_catalogue::ResponseTemplate>& responses,
+	google::protobuf::RepeatedPtrField<serialization::ResponseTemplate>* result) {
+	result->Reserve(static_cast<int>(responses.size()));
+
+	for (auto& response : responses) {
+		auto response_ptr = result->Add();
+		response_ptr->set_head(response.head);
+		response_ptr->set_tail(response.tail);
+	}
+}
+
+std::vector<transport_catalogue::ResponseTemplate> DeserialiseResponses(
+	const google::protobuf::RepeatedPtrField<serialization::ResponseTemplate>& responses) {
+	std::vector<transport_catalogue::ResponseTemplate> result;
+	result.reserve(responses.size());
+
+	for (auto& response : responses) {
+		result.push_back({ response.head(), response.tail() });
+	}
+
+	return result;
+}
+
 map_renderer::RenderSettings DeserialiseRenderSettings(const serialization::TransportDB& db) {
 	map_renderer::RenderSettings result;
 
@@ -214,7 +269,9 @@ void Serialize(
 	std::deque<transport_catalogue::BusToAdd>& buses_to_add,
 	map_renderer::RenderSettings& render_settings,
 	transport_router::RoutingSettings& routing_settings,
-	serialization::Settings& ser_settings) {
+	serialization::Settings& ser_settings,
+	geo::DistanceMode distance_mode,
+	const transport_catalogue::MaterializedResponses& responses) {
 
 	//       
 	serialization::TransportDB db_out;
@@ -240,13 +297,25 @@ void Serialize(
 	router_ptr->set_bus_velocity(routing_settings.bus_velocity);
 	router_ptr->set_bus_wait_time(routing_settings.bus_wait_time);
 
+	//    
+	db_out.mutable_geo_settings()->set_distance_mode(
+		static_cast<serialization::GeoSettings::DistanceMode>(distance_mode));
+
+	//     
+	*db_out.mutable_stop_index() = details::SerialiseNameIndex(details::BuildNameIndex(stops_to_add));
+	*db_out.mutable_bus_index() = details::SerialiseNameIndex(details::BuildNameIndex(buses_to_add));
+
+	//     Stop  Bus     
+	details::SerialiseResponses(responses.stops, db_out.mutable_stop_responses());
+	details::SerialiseResponses(responses.buses, db_out.mutable_bus_responses());
+
 	const std::filesystem::path path = ser_settings.file_name;
 	std::ofstream out_file(path, std::ios::binary);
 	db_out.SerializePartialToOstream(&out_file);
 
 }
 
-std::optional<DeserializedParameters> Deserialize(serialization::Settings& ser_settings) {
+std::optional<DeserializedParameters> Deserialize(const serialization::Settings& ser_settings) {
 	const std::filesystem::path path = ser_settings.file_name;
 	std::ifstream in_file(path, std::ios::binary);
 	
@@ -272,6 +341,17 @@ std::optional<DeserializedParameters> Deserialize(serialization::Settings& ser_s
 	result.routing_settings.bus_velocity = db_in.routing_settings().bus_velocity();
 	result.routing_settings.bus_wait_time = db_in.routing_settings().bus_wait_time();
 
+	//    
+	result.distance_mode = static_cast<geo::DistanceMode>(db_in.geo_settings().distance_mode());
+
+	//  .     ,     
+	result.name_index.stops = details::DeserialiseNameIndex(db_in.stop_index());
+	result.name_index.buses = details::DeserialiseNameIndex(db_in.bus_index());
+
+	//     Stop  Bus
+	result.responses.stops = details::DeserialiseResponses(db_in.stop_responses());
+	result.responses.buses = details::DeserialiseResponses(db_in.bus_responses());
+
 	return result;
 }
 
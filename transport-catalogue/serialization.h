@@ -13,6 +13,8 @@ namespace serialization {
 
 struct Settings {
 	std::string file_name;
+	// Интервал проверки изменения файла базы в режиме serve_requests
+	int reload_interval_ms = 1000;
 };
 
 struct DeserializedParameters {
@@ -20,6 +22,11 @@ struct DeserializedParameters {
 	std::deque<transport_catalogue::BusToAdd> buses_to_add;
 	map_renderer::RenderSettings render_settings;
 	transport_router::RoutingSettings routing_settings;
+	transport_catalogue::NameIndex name_index;
+	// Способ расчета географических расстояний. В старых базах - сферический
+	geo::DistanceMode distance_mode = geo::DistanceMode::SPHERICAL;
+	// Заранее сформированные ответы. В старых базах их нет
+	transport_catalogue::MaterializedResponses responses;
 };
 
 void Serialize(
@@ -27,7 +34,9 @@ void Serialize(
 	std::deque<transport_catalogue::BusToAdd>& buses_to_add,
 	map_renderer::RenderSettings& render_settings,
 	transport_router::RoutingSettings& routing_settings,
-	serialization::Settings& ser_settings);
+	serialization::Settings& ser_settings,
+	geo::DistanceMode distance_mode,
+	const transport_catalogue::MaterializedResponses& responses);
 
-std::optional<DeserializedParameters> Deserialize(serialization::Settings& ser_settings);
+std::optional<DeserializedParameters> Deserialize(const serialization::Settings& ser_settings);
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "snapshot.h"
+
+#include <atomic>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+namespace snapshot {
+
+using namespace std;
+
+// ---------- Snapshot ----------
+
+Snapshot::Snapshot(serialization::DeserializedParameters parameters) {
+	// База данных для работы
+	catalogue_ = make_unique<transport_catalogue::TransportCatalogue>();
+	catalogue_->SetDistanceMode(parameters.distance_mode);
+	catalogue_->FillCatalogue(parameters.stops_to_add, parameters.buses_to_add, move(parameters.name_index));
+
+	// Обработчик маршрутов со встроенным графом маршрутов
+	transport_router_ = make_unique<transport_router::TransportRouter>(*catalogue_, parameters.routing_settings);
+
+	// Обработчик графа маршрутов
+	router_ = make_unique<graph::Router<double>>(transport_router_->GetGraph());
+
+	// Отрисовщик карты маршрутов в формате SVG
+	renderer_ = make_unique<map_renderer::MapRenderer>(parameters.render_settings);
+
+	// Готовые ответы подходят, только если построены по тем же остановкам и маршрутам
+	if (parameters.responses.stops.size() == parameters.stops_to_add.size()
+		&& parameters.responses.buses.size() == parameters.buses_to_add.size()) {
+		responses_ = move(parameters.responses);
+	}
+}
+
+const transport_catalogue::TransportCatalogue& Snapshot::GetCatalogue() const {
+	return *catalogue_;
+}
+
+const transport_router::TransportRouter& Snapshot::GetTransportRouter() const {
+	return *transport_router_;
+}
+
+const graph::Router<double>& Snapshot::GetRouter() const {
+	return *router_;
+}
+
+const map_renderer::MapRenderer& Snapshot::GetRenderer() const {
+	return *renderer_;
+}
+
+const transport_catalogue::MaterializedResponses& Snapshot::GetResponses() const {
+	return responses_;
+}
+
+// Удаление остановки: маршруты через нее получают новые ребра
+optional<vector<const transport_catalogue::Bus*>> Snapshot::RemoveStop(string_view stop_name) {
+	auto changed_buses = catalogue_->RemoveStop(stop_name);
+	if (changed_buses) {
+		UpdateBuses(*changed_buses);
+	}
+	return changed_buses;
+}
+
+// Удаление маршрута: его ребра исключаются из графа
+const transport_catalogue::Bus* Snapshot::RemoveBus(string_view bus_name) {
+	const transport_catalogue::Bus* bus = catalogue_->RemoveBus(bus_name);
+	if (bus == nullptr) {
+		return nullptr;
+	}
+
+	router_->UpdateEdges(transport_router_->RemoveBus(bus).removed, {});
+
+	// Маршрут больше не проходит через свои остановки
+	for (const transport_catalogue::Stop* stop : bus->stops_) {
+		if (stop->id_ < responses_.stops.size()) {
+			responses_.stops[stop->id_] = {};
+		}
+	}
+
+	return bus;
+}
+
+// Задание расстояния: маршруты, в длину которых оно входит, получают новые ребра
+optional<vector<const transport_catalogue::Bus*>> Snapshot::SetDistance(
+	const transport_catalogue::StopsDistance& distance) {
+	if (catalogue_->GetStopByName(distance.stop1_name_) == nullptr
+		|| catalogue_->GetStopByName(distance.stop2_name_) == nullptr) {
+		return nullopt;
+	}
+
+	vector<const transport_catalogue::Bus*> changed_buses = catalogue_->SetDistance(distance);
+	UpdateBuses(changed_buses);
+	return changed_buses;
+}
+
+// Замена ребер измененных маршрутов в графе и матрице маршрутизатора
+void Snapshot::UpdateBuses(const vector<const transport_catalogue::Bus*>& buses) {
+	transport_router::EdgeChanges changes;
+	for (const transport_catalogue::Bus* bus : buses) {
+		transport_router::EdgeChanges bus_changes = transport_router_->UpdateBus(bus);
+		changes.removed.insert(changes.removed.end(), bus_changes.removed.begin(), bus_changes.removed.end());
+		changes.added.insert(changes.added.end(), bus_changes.added.begin(), bus_changes.added.end());
+
+		// Статистика маршрута изменилась
+		if (bus->id_ < responses_.buses.size()) {
+			responses_.buses[bus->id_] = {};
+		}
+	}
+
+	router_->UpdateEdges(changes.removed, changes.added);
+}
+
+// Загрузка снимка из файла базы
+shared_ptr<Snapshot> LoadSnapshot(const serialization::Settings& settings) {
+	optional<serialization::DeserializedParameters> input = serialization::Deserialize(settings);
+
+	if (!input) {
+		return nullptr;
+	}
+
+	return make_shared<Snapshot>(move(*input));
+}
+
+// ---------- SnapshotHolder ----------
+
+shared_ptr<Snapshot> SnapshotHolder::Get() const {
+	return atomic_load(&current_);
+}
+
+void SnapshotHolder::Publish(shared_ptr<Snapshot> snapshot) {
+	atomic_store(&current_, move(snapshot));
+}
+
+// ---------- BaseReloader ----------
+
+BaseReloader::BaseReloader(SnapshotHolder& holder, serialization::Settings settings, chrono::milliseconds interval)
+	: holder_(holder)
+	, settings_(move(settings))
+	, interval_(interval) {
+	// Время изменения файла, из которого построен текущий снимок
+	error_code error;
+	auto write_time = filesystem::last_write_time(settings_.file_name, error);
+	if (!error) {
+		loaded_time_ = write_time;
+		observed_time_ = write_time;
+	}
+
+	thread_ = thread([this] { Run(); });
+}
+
+BaseReloader::~BaseReloader() {
+	{
+		lock_guard guard(mutex_);
+		stop_ = true;
+	}
+	stop_signal_.notify_all();
+	thread_.join();
+}
+
+// Цикл проверки файла базы
+void BaseReloader::Run() {
+	unique_lock lock(mutex_);
+
+	while (!stop_signal_.wait_for(lock, interval_, [this] { return stop_; })) {
+		// Построение снимка может быть долгим, поэтому выполняется без блокировки
+		lock.unlock();
+		CheckBase();
+		lock.lock();
+	}
+}
+
+// Проверка файла базы и публикация нового снимка при его изменении
+void BaseReloader::CheckBase() {
+	error_code error;
+	auto write_time = filesystem::last_write_time(settings_.file_name, error);
+	if (error) {
+		return;
+	}
+
+	// Файл еще записывается: ждем, пока время изменения перестанет меняться
+	if (write_time != observed_time_) {
+		observed_time_ = write_time;
+		return;
+	}
+
+	if (write_time == loaded_time_) {
+		return;
+	}
+
+	// Поврежденный файл повторно не читается до следующего изменения
+	loaded_time_ = write_time;
+
+	try {
+		if (auto next_snapshot = LoadSnapshot(settings_)) {
+			holder_.Publish(move(next_snapshot));
+		}
+		else {
+			cerr << "Can't reload database " << settings_.file_name << endl;
+		}
+	}
+	catch (const exception& e) {
+		cerr << "Can't reload database " << settings_.file_name << ": " << e.what() << endl;
+	}
+}
+
+} // End of snapshot
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "router.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace snapshot {
+
+// Снимок базы: каталог, граф маршрутов, маршрутизатор и отрисовщик карты.
+// Все части создаются один раз в конструкторе. Запросы чтения снимок не меняют,
+// поэтому его можно одновременно использовать из нескольких потоков, а изменения
+// базы выполняются, только пока снимок не читают другие потоки
+class Snapshot {
+public:
+	explicit Snapshot(serialization::DeserializedParameters parameters);
+
+	Snapshot(const Snapshot&) = delete;
+	Snapshot& operator=(const Snapshot&) = delete;
+
+	const transport_catalogue::TransportCatalogue& GetCatalogue() const;
+	const transport_router::TransportRouter& GetTransportRouter() const;
+	const graph::Router<double>& GetRouter() const;
+	const map_renderer::MapRenderer& GetRenderer() const;
+
+	// Готовые ответы на запросы Stop и Bus из базы по номерам остановок и маршрутов
+	const transport_catalogue::MaterializedResponses& GetResponses() const;
+
+	// Изменения базы с результатами одноименных методов каталога. Граф и матрица
+	// маршрутизатора обновляются только по ребрам затронутых маршрутов, их готовые
+	// ответы сбрасываются. Изменения действуют до загрузки базы из файла
+	std::optional<std::vector<const transport_catalogue::Bus*>> RemoveStop(std::string_view stop_name);
+	const transport_catalogue::Bus* RemoveBus(std::string_view bus_name);
+
+	// Возвращает nullopt, если одной из остановок нет в базе
+	std::optional<std::vector<const transport_catalogue::Bus*>> SetDistance(
+		const transport_catalogue::StopsDistance& distance);
+
+private:
+	// Части ссылаются друг на друга, поэтому хранятся по указателю и
+	// разрушаются в порядке, обратном созданию
+	std::unique_ptr<transport_catalogue::TransportCatalogue> catalogue_;
+	std::unique_ptr<transport_router::TransportRouter> transport_router_;
+	std::unique_ptr<graph::Router<double>> router_;
+	std::unique_ptr<map_renderer::MapRenderer> renderer_;
+
+	transport_catalogue::MaterializedResponses responses_;
+
+	// Замена ребер измененных маршрутов в графе и матрице маршрутизатора
+	void UpdateBuses(const std::vector<const transport_catalogue::Bus*>& buses);
+};
+
+// Загрузка снимка из файла базы. Возвращает nullptr, если базу прочитать не удалось
+std::shared_ptr<Snapshot> LoadSnapshot(const serialization::Settings& settings);
+
+// Текущий опубликованный снимок. Читатели берут снимок целиком и работают с ним
+// до конца обработки запросов, а новый снимок подменяется атомарной заменой указателя.
+// Старый снимок удаляется, когда его отпускает последний читатель. Изменения базы
+// в старом снимке в новый не переносятся
+class SnapshotHolder {
+public:
+	// Получение текущего снимка. Может вернуть nullptr, если снимок еще не опубликован
+	std::shared_ptr<Snapshot> Get() const;
+
+	// Публикация нового снимка
+	void Publish(std::shared_ptr<Snapshot> snapshot);
+
+private:
+	std::shared_ptr<Snapshot> current_;
+};
+
+// Фоновая перезагрузка базы. Поток периодически проверяет время изменения файла базы,
+// строит по новому файлу снимок и публикует его. Файл читается после того, как
+// время его изменения не менялось в течение одного интервала проверки
+class BaseReloader {
+public:
+	BaseReloader(SnapshotHolder& holder, serialization::Settings settings, std::chrono::milliseconds interval);
+
+	BaseReloader(const BaseReloader&) = delete;
+	BaseReloader& operator=(const BaseReloader&) = delete;
+
+	// Остановка фонового потока
+	~BaseReloader();
+
+private:
+	SnapshotHolder& holder_;
+	serialization::Settings settings_;
+	std::chrono::milliseconds interval_;
+
+	// Время изменения файла, по которому построен опубликованный снимок, и
+	// время изменения, замеченное на предыдущей проверке
+	std::optional<std::filesystem::file_time_type> loaded_time_;
+	std::optional<std::filesystem::file_time_type> observed_time_;
+
+	std::mutex mutex_;
+	std::condition_variable stop_signal_;
+	bool stop_ = false;
+
+	std::thread thread_;
+
+	// Цикл проверки файла базы
+	void Run();
+
+	// Проверка файла базы и публикация нового снимка при его изменении
+	void CheckBase();
+};
+
+} // End of snapshot
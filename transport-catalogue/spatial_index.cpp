@@ -0,0 +1,163 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace geo {
+
+using namespace std;
+
+namespace {
+
+// Перевод координат в точку на единичной сфере
+void ToUnitSphere(Coordinates point, double* xyz) {
+	static const double dr = M_PI / 180.;
+	const double lat = point.lat * dr;
+	const double lng = point.lng * dr;
+	xyz[0] = cos(lat) * cos(lng);
+	xyz[1] = cos(lat) * sin(lng);
+	xyz[2] = sin(lat);
+}
+
+double SquaredDistance(const double* lhs, const double* rhs) {
+	const double dx = lhs[0] - rhs[0];
+	const double dy = lhs[1] - rhs[1];
+	const double dz = lhs[2] - rhs[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+} // End of namespace
+
+// Построение по массивам широт и долгот. Номер точки - ее позиция в массивах
+KdTree::KdTree(const double* lats, const double* lngs, size_t count) {
+	nodes_.reserve(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		Node node;
+		node.location = { lats[i], lngs[i] };
+		ToUnitSphere(node.location, node.xyz);
+		node.id = static_cast<uint32_t>(i);
+		nodes_.push_back(node);
+	}
+
+	Build(0, nodes_.size(), 0);
+
+	positions_.resize(nodes_.size());
+	for (size_t i = 0; i < nodes_.size(); ++i) {
+		positions_[nodes_[i].id] = static_cast<uint32_t>(i);
+	}
+}
+
+// Разбиение поддерева [begin, end) по медиане вдоль оси текущей глубины
+void KdTree::Build(size_t begin, size_t end, int depth) {
+	if (end - begin < 2) {
+		return;
+	}
+
+	const int axis = depth % 3;
+	const size_t middle = begin + (end - begin) / 2;
+
+	nth_element(nodes_.begin() + begin, nodes_.begin() + middle, nodes_.begin() + end,
+		[axis](const Node& lhs, const Node& rhs) {
+			return lhs.xyz[axis] < rhs.xyz[axis];
+		});
+
+	Build(begin, middle, depth + 1);
+	Build(middle + 1, end, depth + 1);
+}
+
+// Поиск не более count ближайших точек
+vector<NearestPoint> KdTree::FindNearest(Coordinates target, size_t count, DistanceMode mode) const {
+	vector<NearestPoint> result;
+	count = min(count, nodes_.size());
+	if (count == 0) {
+		return result;
+	}
+
+	double target_xyz[3];
+	ToUnitSphere(target, target_xyz);
+
+	// Найденные кандидаты: на вершине - самый дальний из них
+	priority_queue<pair<double, size_t>> best;
+
+	// Обход дерева с отсечением поддеревьев, которые не могут содержать
+	// точки ближе самого дальнего из найденных кандидатов
+	auto search = [&](auto& self, size_t begin, size_t end, int depth) -> void {
+		if (begin >= end) {
+			return;
+		}
+
+		const size_t middle = begin + (end - begin) / 2;
+		const Node& node = nodes_[middle];
+
+		// Удаленные точки участвуют только в разбиении пространства
+		if (!node.removed) {
+			const double distance = SquaredDistance(node.xyz, target_xyz);
+			if (best.size() < count) {
+				best.emplace(distance, middle);
+			}
+			else if (distance < best.top().first) {
+				best.pop();
+				best.emplace(distance, middle);
+			}
+		}
+
+		const int axis = depth % 3;
+		const double axis_delta = target_xyz[axis] - node.xyz[axis];
+
+		// Сначала проверяется половина, в которой лежит искомая точка
+		if (axis_delta < 0) {
+			self(self, begin, middle, depth + 1);
+		}
+		else {
+			self(self, middle + 1, end, depth + 1);
+		}
+
+		// Вторая половина проверяется, только если граница ближе самого дальнего кандидата
+		if (best.size() < count || axis_delta * axis_delta < best.top().first) {
+			if (axis_delta < 0) {
+				self(self, middle + 1, end, depth + 1);
+			}
+			else {
+				self(self, begin, middle, depth + 1);
+			}
+		}
+	};
+
+	search(search, 0, nodes_.size(), 0);
+
+	result.reserve(best.size());
+	while (!best.empty()) {
+		const Node& node = nodes_[best.top().second];
+		result.push_back({ node.id, ComputeDistance(target, node.location, mode) });
+		best.pop();
+	}
+
+	sort(result.begin(), result.end(), [](const NearestPoint& lhs, const NearestPoint& rhs) {
+		return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.id < rhs.id);
+	});
+
+	return result;
+}
+
+// Исключение точки из результатов поиска
+void KdTree::Remove(uint32_t id) {
+	if (id < positions_.size()) {
+		nodes_[positions_[id]].removed = true;
+	}
+}
+
+// Количество точек в дереве
+size_t KdTree::Size() const {
+	return nodes_.size();
+}
+
+// Расход памяти на узлы дерева
+memory_usage::Usage KdTree::GetMemoryUsage() const {
+	return { nodes_.size(), memory_usage::Bytes(nodes_) + memory_usage::Bytes(positions_) };
+}
+
+} // namespace geo
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geo.h"
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace geo {
+
+// Результат поиска ближайшей точки: номер точки и расстояние до нее в метрах
+struct NearestPoint {
+	uint32_t id;
+	double distance;
+};
+
+// k-d дерево по точкам на поверхности Земли.
+// Координаты переводятся в точки единичной сферы, расстояние по хорде между которыми
+// монотонно зависит от расстояния по поверхности. Поэтому поиск k ближайших точек
+// выполняется за логарифмическое время без вычисления тригонометрии для каждой точки
+class KdTree {
+public:
+	KdTree() = default;
+
+	// Построение по массивам широт и долгот. Номер точки - ее позиция в массивах
+	KdTree(const double* lats, const double* lngs, size_t count);
+
+	// Поиск не более count ближайших точек. Результат отсортирован по возрастанию расстояния.
+	// Порядок точек определяется по хорде, mode задает только расчет расстояния в результате
+	std::vector<NearestPoint> FindNearest(Coordinates target, size_t count,
+		DistanceMode mode = DistanceMode::SPHERICAL) const;
+
+	// Исключение точки из результатов поиска. Структура дерева не меняется
+	void Remove(uint32_t id);
+
+	// Количество точек в дереве
+	size_t Size() const;
+
+	// Расход памяти на узлы дерева
+	memory_usage::Usage GetMemoryUsage() const;
+
+private:
+	struct Node {
+		double xyz[3];
+		Coordinates location;
+		uint32_t id;
+		bool removed = false;
+	};
+
+	// Позиции узлов по номерам точек
+	std::vector<uint32_t> positions_;
+
+	// Узлы неявного сбалансированного дерева: корень поддерева [begin, end)
+	// лежит в его середине, ось разбиения зависит от глубины
+	std::vector<Node> nodes_;
+
+	void Build(size_t begin, size_t end, int depth);
+};
+
+} // namespace geo
@@ -3,92 +3,182 @@
 #include <cassert>
 #include <unordered_set>
 #include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
 namespace transport_catalogue {
 
-// Добавление остановки в базу
-void TransportCatalogue::AddStop(Stop&& stop) {
-	// Добавляем остановку в массив
-	Stop* ptr = &all_stops_.emplace_back(move(stop));
+namespace {
+
+// Проверка, что индекс названий соответствует порядку элементов в базе
+template <typename Container>
+bool IndexMatches(const PerfectHash& index, const Container& items) {
+	if (index.Size() != items.size()) {
+		return false;
+	}
 
-	// Добавляем информацию об остановке в лист остановок
-	stops_list_[ptr->name_] = ptr;
+	for (size_t i = 0; i < items.size(); ++i) {
+		auto id = index.Find(items[i].name_);
+		if (!id || *id != i) {
+			return false;
+		}
+	}
 
-	// Добавляем остановку в словарь остановок со списком маршрутов
-	buses_to_stop_[ptr];
+	return true;
 }
 
-// Добавление маршрута в базу
-void TransportCatalogue::AddBus(string_view name, bool is_circle, vector<string_view>& stops_list_add) {
-	// Создаем узел Bus
-	Bus bus;
+// Построение индекса названий неудаленных элементов базы
+template <typename Container>
+PerfectHash BuildIndex(const Container& items, const vector<bool>& removed) {
+	vector<string_view> names;
+	vector<uint32_t> ids;
+	names.reserve(items.size());
+	ids.reserve(items.size());
+
+	for (const auto& item : items) {
+		if (!removed[item.id_]) {
+			names.push_back(item.name_);
+			ids.push_back(item.id_);
+		}
+	}
 
-	// Присваиваем имя и тип маршрута
-	bus.name_ = string(name);
-	bus.is_circle_ = is_circle;
+	return PerfectHash(names, ids);
+}
 
-	// Создаем массив указателей на остановки на основании переданных названии
-	bus.stops_.reserve(stops_list_add.size());
+// Поиск номера элемента по индексу с проверкой названия
+template <typename Container>
+optional<size_t> FindByIndex(const PerfectHash& index, const Container& items, const vector<bool>& removed, string_view name) {
+	auto id = index.Find(name);
 
-	// Добавляем маршрут в массив с маршрутами
-	Bus* bus_ptr = &all_buses_.emplace_back(move(bus));
+	if (id && *id < items.size() && !removed[*id] && items[*id].name_ == name) {
+		return *id;
+	}
 
-	// По указателю на маршрут заполняем список остановок, вместе с этим обновляя
-	// словарь остановок со списком маршрутов
-	for (string_view stop_name : stops_list_add) {
-		// Находим указатель на остановку
-		auto& stop_ptr = stops_list_.at(stop_name);
+	return nullopt;
+}
 
-		// Копируем указатель на остановку внутрь маршрута
-		bus_ptr->stops_.push_back(stop_ptr);
+// Сравнение названий в порядке сортировки списков каталога
+bool NameLess(string_view left, string_view right) {
+	return lexicographical_compare(left.begin(), left.end(), right.begin(), right.end());
+}
 
-		// Находим остановку в словаре остановок со списком маршрутов и добавляем
-		// в список маршрут
-		//buses_to_stop_[stop_ptr].insert(bus_ptr->name_);
-		buses_to_stop_[stop_ptr].insert(bus_ptr);
+// Сортировка списка указателей по названию
+template <typename Item>
+vector<const Item*> SortByName(const deque<Item>& items, const vector<bool>& removed) {
+	vector<const Item*> result;
+	result.reserve(items.size());
+
+	for (const Item& item : items) {
+		if (!removed[item.id_]) {
+			result.push_back(&item);
+		}
 	}
 
-	// Добавляем информацию о маршруте в лист маршрутов
-	buses_list_[bus_ptr->name_] = bus_ptr;
+	sort(result.begin(), result.end(),
+		[](const Item* left, const Item* right)
+		{
+			return NameLess(left->name_, right->name_);
+		});
+
+	return result;
 }
 
-void TransportCatalogue::AddBus(const BusToAdd& bus_to_add) {
-	// Создаем узел Bus
-	Bus bus;
+// Поиск по префиксу в отсортированном по названию списке. Все подходящие названия
+// лежат подряд, начиная с первого названия не меньше префикса
+template <typename Item>
+vector<const Item*> FindByPrefix(const vector<const Item*>& sorted_items, string_view prefix, size_t count) {
+	vector<const Item*> result;
 
-	// Присваиваем имя и тип маршрута
-	bus.name_ = bus_to_add.name;
-	bus.is_circle_ = bus_to_add.is_circle;
+	auto it = lower_bound(sorted_items.begin(), sorted_items.end(), prefix,
+		[](const Item* item, string_view value) {
+			return NameLess(item->name_, value);
+		});
 
-	// Создаем массив указателей на остановки на основании переданных названии
-	bus.stops_.reserve(bus_to_add.stops.size());
+	for (; it != sorted_items.end() && result.size() < count; ++it) {
+		if ((*it)->name_.substr(0, prefix.size()) != prefix) {
+			break;
+		}
+		result.push_back(*it);
+	}
 
-	// Добавляем маршрут в массив с маршрутами
-	Bus* bus_ptr = &all_buses_.emplace_back(move(bus));
+	return result;
+}
 
-	// По указателю на маршрут заполняем список остановок, вместе с этим обновляя
-	// словарь остановок со списком маршрутов
-	for (string_view stop_name : bus_to_add.stops) {
-		// Находим указатель на остановку
-		auto& stop_ptr = stops_list_.at(stop_name);
+// Номер младшего установленного бита. Слово не должно быть нулевым
+int LowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#else
+	int result = 0;
+	while ((word & 1) == 0) {
+		word >>= 1;
+		++result;
+	}
+	return result;
+#endif
+}
 
-		// Копируем указатель на остановку внутрь маршрута
-		bus_ptr->stops_.push_back(stop_ptr);
+} // End of namespace
 
-		// Находим остановку в словаре остановок со списком маршрутов и добавляем
-		// в список маршрут
-		//buses_to_stop_[stop_ptr].insert(bus_ptr->name_);
-		buses_to_stop_[stop_ptr].insert(bus_ptr);
+// Добавление остановки в базу
+void TransportCatalogue::AddStop(Stop&& stop) {
+	// Названия остановок должны быть уникальными
+	if (GetStopByName(stop.name_) != nullptr) {
+		throw invalid_argument("Duplicate stop: "s + string(stop.name_));
+	}
+
+	const Stop* stop_ptr = PushStop(move(stop));
+	// Название удаленной остановки могло остаться в словаре со старым номером
+	new_stop_names_.insert_or_assign(stop_ptr->name_, stop_ptr->id_);
+	if (new_stop_names_.size() > stop_index_.Size()) {
+		RebuildStopIndex();
+	}
+
+	search_outdated_ = true;
+}
+
+// Добавление маршрута в базу
+void TransportCatalogue::AddBus(string_view name, bool is_circle, vector<string_view>& stops_list_add) {
+	// Названия маршрутов должны быть уникальными
+	if (GetBusByName(name) != nullptr) {
+		throw invalid_argument("Duplicate bus: "s + string(name));
+	}
+
+	// Находим указатели на остановки до добавления маршрута, чтобы при ошибке
+	// в названии остановки база не менялась
+	vector<const Stop*> stops;
+	stops.reserve(stops_list_add.size());
+	for (string_view stop_name : stops_list_add) {
+		stops.push_back(FindStop(stop_name));
+	}
+
+	// Добавляем маршрут в массив с маршрутами
+	Bus* bus_ptr = PushBus(name, is_circle, stops);
+
+	UpdateBusStat(bus_ptr);
+
+	new_bus_names_.insert_or_assign(bus_ptr->name_, bus_ptr->id_);
+	if (new_bus_names_.size() > bus_index_.Size()) {
+		RebuildBusIndex();
 	}
 
-	// Добавляем информацию о маршруте в лист маршрутов
-	buses_list_[bus_ptr->name_] = bus_ptr;
+	search_outdated_ = true;
+}
+
+void TransportCatalogue::AddBus(const BusToAdd& bus_to_add) {
+	vector<string_view> stops_list_add(bus_to_add.stops.begin(), bus_to_add.stops.end());
+	AddBus(bus_to_add.name, bus_to_add.is_circle, stops_list_add);
 }
 
 // Заполнение базы из набора данных
 void TransportCatalogue::FillCatalogue(const std::deque<StopToAdd>& stops_to_add, const std::deque<BusToAdd>& buses_to_add) {
+	FillCatalogue(stops_to_add, buses_to_add, {});
+}
+
+// Заполнение базы из набора данных с готовыми индексами названий из базы
+void TransportCatalogue::FillCatalogue(const std::deque<StopToAdd>& stops_to_add, const std::deque<BusToAdd>& buses_to_add,
+	NameIndex name_index) {
 	// Добваление остановок в базу
 	for (auto& stop_to_add : stops_to_add) {
 		Stop stop;
@@ -96,9 +186,20 @@ void TransportCatalogue::FillCatalogue(const std::deque<StopToAdd>& stops_to_add
 		stop.name_ = stop_to_add.name;
 		stop.location_ = stop_to_add.location;
 
-		AddStop(move(stop));
+		PushStop(move(stop));
 	}
-	
+
+	// Индекс остановок нужен для добавления расстояний и маршрутов
+	if (IndexMatches(name_index.stops, all_stops_)) {
+		stop_index_ = move(name_index.stops);
+		new_stop_names_.clear();
+	}
+	else {
+		RebuildStopIndex();
+	}
+
+	RebuildStopSearch();
+
 	// Добавление расстояний между остановками
 	for (auto& stop_to_add : stops_to_add) {
 		StopsDistance distance;
@@ -112,49 +213,70 @@ void TransportCatalogue::FillCatalogue(const std::deque<StopToAdd>& stops_to_add
 		}
 	}
 
-	// Добавление маршрутов
+	// Добавление маршрутов. Номера остановок всех маршрутов ложатся в общий массив подряд
+	size_t route_stop_count = 0;
 	for (auto& bus_to_add : buses_to_add) {
-		AddBus(bus_to_add);
+		route_stop_count += bus_to_add.stops.size();
+	}
+	route_stop_ids_.reserve(route_stop_ids_.size() + route_stop_count);
+
+	vector<const Stop*> stops;
+	for (auto& bus_to_add : buses_to_add) {
+		stops.clear();
+		for (const string& stop_name : bus_to_add.stops) {
+			stops.push_back(FindStop(stop_name));
+		}
+
+		PushBus(bus_to_add.name, bus_to_add.is_circle, stops);
+	}
+
+	// Расчет статистики всех маршрутов
+	for (const Bus& bus : all_buses_) {
+		UpdateBusStat(&bus);
+	}
+
+	if (IndexMatches(name_index.buses, all_buses_)) {
+		bus_index_ = move(name_index.buses);
+		new_bus_names_.clear();
 	}
-	
+	else {
+		RebuildBusIndex();
+	}
+
+	RebuildBusSearch();
+	RebuildStopBusBits();
+	search_outdated_ = false;
 }
 
 
 // Поиск остановки по имени. Возвращает указатель на остановку
 // Если остановки нет, то возвращает нулевой указатель
 const Stop* TransportCatalogue::GetStopByName(std::string_view stop_name) const {
-	Stop* stop = nullptr;
-
-	if (stops_list_.count(stop_name)) {
-		stop = stops_list_.at(stop_name);
+	if (auto id = FindStopId(stop_name)) {
+		return &all_stops_[*id];
 	}
 
-	return stop;
+	return nullptr;
 }
 
 // Поиск маршрута по имени. Возвращает указатель на маршрут
 // Если остановки нет, то возвращает нулевой указатель
 const Bus* TransportCatalogue::GetBusByName(string_view bus_name) const {
-	Bus* bus = nullptr;
-
-	if (buses_list_.count(bus_name)) {
-		bus = buses_list_.at(bus_name);
+	if (auto id = FindBusId(bus_name)) {
+		return &all_buses_[*id];
 	}
 
-	return bus;
+	return nullptr;
 }
 
 // Поиск остановки по имени. Возвращает указатель на список маршрутов через остановку
 // Если остановки нет, то возвращает нулевой указатель
-//const set<string_view>* TransportCatalogue::FindStop(string_view stop_name) const {
 const set<const Bus*>* TransportCatalogue::GetBusesToStop(string_view stop_name) const {
-	//const set<Bus*>* TransportCatalogue::FindStop(string_view stop_name) const{
-		// Проверка наличия остановки в словаре остановок
-	if (stops_list_.count(stop_name)) {
-		// Если остановка есть, то берем указать на нее и по нему ищем список маршрутов для
+	// Проверка наличия остановки в базе
+	if (auto id = FindStopId(stop_name)) {
+		// Если остановка есть, то по указателю на нее ищем список маршрутов для
 		// остановки. Возвращаем указатель на список
-		//return &buses_to_stop_.at(stops_list_.at(stop_name));
-		return &buses_to_stop_.at(stops_list_.at(stop_name));
+		return &buses_to_stop_.at(&all_stops_[*id]);
 	}
 
 	return nullptr;
@@ -163,22 +285,118 @@ const set<const Bus*>* TransportCatalogue::GetBusesToStop(string_view stop_name)
 
 
 // Задание дистанции между остановками
-void TransportCatalogue::SetDistance(StopsDistance& distance) {
+vector<const Bus*> TransportCatalogue::SetDistance(const StopsDistance& distance) {
 	// Возврат указателей на остановки
-	Stop* stop1_ptr = stops_list_.at(distance.stop1_name_);
-	Stop* stop2_ptr = stops_list_.at(distance.stop2_name_);
+	const Stop* stop1_ptr = FindStop(distance.stop1_name_);
+	const Stop* stop2_ptr = FindStop(distance.stop2_name_);
 
 	// Внесение значения в словарь
 	stop_distance_[{stop1_ptr, stop2_ptr}] = distance.distance_;
+
+	// Расстояние влияет только на маршруты, проходящие через обе остановки.
+	// При заполнении базы маршрутов еще нет, и проверка ничего не стоит
+	vector<const Bus*> changed_buses;
+	const auto& stop1_buses = buses_to_stop_.at(stop1_ptr);
+	const auto& stop2_buses = buses_to_stop_.at(stop2_ptr);
+
+	for (const Bus* bus_ptr : stop1_buses) {
+		if (stop2_buses.count(bus_ptr) != 0 && UsesDistance(*bus_ptr, stop1_ptr, stop2_ptr)) {
+			UpdateBusStat(bus_ptr);
+			changed_buses.push_back(bus_ptr);
+		}
+	}
+
+	return changed_buses;
+}
+
+// Проверка по тем же парам остановок, по которым StopsCount считает длину маршрута.
+// Расстояние без пары в обратную сторону используется для обоих направлений
+bool TransportCatalogue::UsesDistance(const Bus& bus, const Stop* stop1_ptr, const Stop* stop2_ptr) const {
+	// Участки через удаленные остановки складываются из расстояний исходного списка
+	const StopSequence& source = bus_source_stops_[bus.id_];
+	for (size_t i = 1; i < source.size(); ++i) {
+		if ((source[i - 1] == stop1_ptr && source[i] == stop2_ptr)
+			|| (source[i - 1] == stop2_ptr && source[i] == stop1_ptr)) {
+			return true;
+		}
+	}
+
+	// Линейный маршрут разворачивается на конечных остановках текущего списка
+	const StopSequence& stops = bus.stops_;
+	return stops.size() >= 2 && !bus.is_circle_ && stop1_ptr == stop2_ptr
+		&& (stop1_ptr == stops.front() || stop1_ptr == stops.back());
+}
+
+// Удаление остановки
+optional<vector<const Bus*>> TransportCatalogue::RemoveStop(string_view stop_name) {
+	auto id = FindStopId(stop_name);
+	if (!id) {
+		return nullopt;
+	}
+
+	UpdateSearch();
+
+	const Stop* stop_ptr = &all_stops_[*id];
+
+	// Изменяются только маршруты, проходящие через остановку
+	vector<const Bus*> changed_buses(buses_to_stop_.at(stop_ptr).begin(), buses_to_stop_.at(stop_ptr).end());
+
+	// Расстояния до удаленной остановки остаются в словаре: автобус проезжает ее без
+	// остановки, и участок между соседними остановками проходит через нее
+	removed_stops_[*id] = true;
+	for (const Bus* bus_ptr : changed_buses) {
+		UpdateBusStat(bus_ptr);
+	}
+
+	buses_to_stop_.erase(stop_ptr);
+	stops_tree_.Remove(stop_ptr->id_);
+	sorted_stops_.erase(find(sorted_stops_.begin(), sorted_stops_.end(), stop_ptr));
+
+	// Через удаленную остановку больше не проходит ни один маршрут
+	const auto stop_bits = stop_bus_bits_.begin() + stop_ptr->id_ * bus_words_;
+	fill(stop_bits, stop_bits + bus_words_, 0);
+
+	return changed_buses;
+}
+
+// Удаление маршрута
+const Bus* TransportCatalogue::RemoveBus(string_view bus_name) {
+	auto id = FindBusId(bus_name);
+	if (!id) {
+		return nullptr;
+	}
+
+	UpdateSearch();
+
+	const Bus* bus_ptr = &all_buses_[*id];
+
+	// Исключение маршрута из списков и битовых масок маршрутов его остановок
+	const uint64_t bus_bit = uint64_t(1) << (bus_ptr->id_ % 64);
+	for (const Stop* stop_ptr : bus_ptr->stops_) {
+		buses_to_stop_.at(stop_ptr).erase(bus_ptr);
+		stop_bus_bits_[stop_ptr->id_ * bus_words_ + bus_ptr->id_ / 64] &= ~bus_bit;
+	}
+
+	removed_buses_[*id] = true;
+	sorted_buses_.erase(find(sorted_buses_.begin(), sorted_buses_.end(), bus_ptr));
+
+	return bus_ptr;
 }
 
 // Получение физического расстояния между остановками из словаря. Возвращает ноль,
 // если ищется одна и та же остановка, или такой пары остановок нет
 int TransportCatalogue::GetDistance(string_view stop1, string_view stop2) const {
 	// Возврат указателей на остановки
-	Stop* stop1_ptr = stops_list_.at(stop1);
-	Stop* stop2_ptr = stops_list_.at(stop2);
+	return DistanceBetween(FindStop(stop1), FindStop(stop2));
+}
+
+// Координаты остановок для пакетного расчета расстояний
+geo::PointArrays TransportCatalogue::GetStopPoints() const {
+	return { stop_lats_.data(), stop_lngs_.data(), stop_sin_lats_.data(), stop_cos_lats_.data() };
+}
 
+// Расстояние между остановками. 0, если расстояние не задано
+int TransportCatalogue::DistanceBetween(const Stop* stop1_ptr, const Stop* stop2_ptr) const {
 	// Буффер для расстояния
 	int distance;
 
@@ -198,23 +416,112 @@ int TransportCatalogue::GetDistance(string_view stop1, string_view stop2) const
 	return distance;
 }
 
+// Участки маршрута по исходному списку остановок. Расстояния пропущенных участков
+// копятся и входят в участок до следующей оставшейся остановки
+TransportCatalogue::RouteLegs TransportCatalogue::MakeRouteLegs(const StopSequence& stops, bool is_circle,
+	const function<bool(const Stop*)>& excluded) const {
+	RouteLegs legs;
+	if (stops.empty()) {
+		return legs;
+	}
+
+	// Географические расстояния между соседними остановками считаются одним пакетом
+	vector<double> segment_geo(stops.size() - 1);
+	geo::ComputeSegmentDistances(GetStopPoints(), stops.GetIds(), stops.size(), segment_geo.data(), distance_mode_);
+
+	// Накопленные расстояния от последней оставшейся остановки и до первой
+	int forward = 0, backward = 0;
+	double geo_length = 0.0;
+	int lead_forward = 0, lead_backward = 0;
+	double lead_geo = 0.0;
+
+	for (size_t i = 0; i < stops.size(); ++i) {
+		const Stop* stop_ptr = stops[i];
+
+		if (i > 0) {
+			forward += DistanceBetween(stops[i - 1], stop_ptr);
+			backward += DistanceBetween(stop_ptr, stops[i - 1]);
+			geo_length += segment_geo[i - 1];
+		}
+
+		// Исключенная остановка и повтор предыдущей после исключения пропускаются
+		if (excluded && (excluded(stop_ptr) || (!legs.stops.empty() && legs.stops.back() == stop_ptr))) {
+			continue;
+		}
+
+		if (legs.stops.empty()) {
+			lead_forward = forward;
+			lead_backward = backward;
+			lead_geo = geo_length;
+		}
+		else {
+			legs.forward.push_back(forward);
+			legs.backward.push_back(backward);
+			legs.geo.push_back(geo_length);
+		}
+
+		legs.stops.push_back(stop_ptr);
+		forward = backward = 0;
+		geo_length = 0.0;
+	}
+
+	// Кольцевой маршрут остается замкнутым: путь от последней оставшейся остановки
+	// до первой проходит через исключенные. Линейный маршрут разворачивается
+	// на оставшихся конечных остановках
+	if (!excluded || !is_circle || legs.stops.size() < 2) {
+		return legs;
+	}
+
+	if (legs.stops.front() != legs.stops.back()) {
+		legs.forward.push_back(forward + lead_forward);
+		legs.backward.push_back(backward + lead_backward);
+		legs.geo.push_back(geo_length + lead_geo);
+		legs.stops.push_back(legs.stops.front());
+	}
+	else {
+		legs.forward.back() += forward + lead_forward;
+		legs.backward.back() += backward + lead_backward;
+		legs.geo.back() += geo_length + lead_geo;
+	}
+
+	return legs;
+}
+
+// Участки маршрута без удаленных остановок
+TransportCatalogue::RouteLegs TransportCatalogue::GetRouteLegs(const Bus* bus_ptr) const {
+	const StopSequence& source = bus_source_stops_[bus_ptr->id_];
+	const auto is_removed = [this](const Stop* stop_ptr) { return removed_stops_[stop_ptr->id_]; };
+
+	// Список без удаленных остановок остается в исходном виде
+	if (none_of(source.begin(), source.end(), is_removed)) {
+		return MakeRouteLegs(source, bus_ptr->is_circle_, nullptr);
+	}
+	return MakeRouteLegs(source, bus_ptr->is_circle_, is_removed);
+}
+
 // Расчет количества остановок на маршруте и географическую длину
 // Возврат (общее, уникальное, расстояние, извилистость)
-BusStat TransportCatalogue::StopsCount(const Bus* bus_ptr) const {
+BusStat TransportCatalogue::StopsCount(const RouteLegs& legs, bool is_circle) const {
+	const vector<const Stop*>& stops = legs.stops;
+
+	// Маршрут, все остановки которого удалены, пуст
+	if (stops.empty()) {
+		return { 0.0, 0, 0, 0 };
+	}
 
 	// Проверяем, что остановок больше чем 1
-	if (bus_ptr->stops_.size() < 2) {
+	if (stops.size() < 2) {
 		return { 0.0, 0, 1, 1 };
 	}
 
 	// Количество остановок в списке
-	size_t list_size = bus_ptr->stops_.size();
+	size_t list_size = stops.size();
 
 	// Количество остановок на маршруте
 	int number_of_stops;
 
 	// Корректируем значения в зависимости от типа маршрута
-	bus_ptr->is_circle_ ? number_of_stops = list_size : number_of_stops = 2 * list_size - 1;
+	is_circle ? number_of_stops = list_size : number_of_stops = 2 * list_size - 1;
 
 	// Список уникальных остановок
 	unordered_set<string_view> single_names;
@@ -230,40 +537,38 @@ BusStat TransportCatalogue::StopsCount(const Bus* bus_ptr) const {
 
 	// Если маршрут кольцевой, то проходим по списку остановок 1 раз
 	// Если маршрут линейный, то учитываем двойное расстояние
-	if (bus_ptr->is_circle_) {
+	if (is_circle) {
 		for (size_t i = 1; i < list_size; ++i) {
 			// Перенос названий остановок в список
-			single_names.insert(bus_ptr->stops_[i - 1]->name_);
-			single_names.insert(bus_ptr->stops_[i]->name_);
+			single_names.insert(stops[i - 1]->name_);
+			single_names.insert(stops[i]->name_);
 
 			// Расчет географического расстояния между остановками
-			distance_geo += geo::ComputeDistance(bus_ptr->stops_[i - 1]->location_, bus_ptr->stops_[i]->location_);
+			distance_geo += legs.geo[i - 1];
 
 			// Расчет фактического расстояния между остановками
-			distance_fact += GetDistance(bus_ptr->stops_[i - 1]->name_, bus_ptr->stops_[i]->name_);
+			distance_fact += legs.forward[i - 1];
 		}
 	}
 	else {
 		for (size_t i = 1; i < list_size; ++i) {
 			// Перенос названий остановок в список
-			single_names.insert(bus_ptr->stops_[i - 1]->name_);
-			single_names.insert(bus_ptr->stops_[i]->name_);
+			single_names.insert(stops[i - 1]->name_);
+			single_names.insert(stops[i]->name_);
 
 			// Расчет географического расстояния между остановками (удвоенное)
-			distance_geo += 2 * geo::ComputeDistance(bus_ptr->stops_[i - 1]->location_, bus_ptr->stops_[i]->location_);
+			distance_geo += 2 * legs.geo[i - 1];
 
 			// Расчет фактического расстояния между остановками.
 			// Прибавляется расстояние в одну и другую сторону
-			distance_fact +=
-				GetDistance(bus_ptr->stops_[i - 1]->name_, bus_ptr->stops_[i]->name_) +
-				GetDistance(bus_ptr->stops_[i]->name_, bus_ptr->stops_[i - 1]->name_);
+			distance_fact += legs.forward[i - 1] + legs.backward[i - 1];
 		}
 
 		// К фактическому расстоянию добавляем расстояние, которое нужно пройти
 		// автобусу для возврата на ту же остановку (начало и конец)
 		distance_fact +=
-			GetDistance(bus_ptr->stops_[0]->name_, bus_ptr->stops_[0]->name_) +
-			GetDistance(bus_ptr->stops_[list_size - 1]->name_, bus_ptr->stops_[list_size - 1]->name_);
+			DistanceBetween(stops[0], stops[0]) +
+			DistanceBetween(stops[list_size - 1], stops[list_size - 1]);
 
 	}
 
@@ -273,7 +578,7 @@ BusStat TransportCatalogue::StopsCount(const Bus* bus_ptr) const {
 	double curvature = distance_fact / distance_geo;
 
 	//return { number_of_stops, unique_stops, distance_fact, curvature };
-	return { curvature, distance_fact, number_of_stops, unique_stops };
+	return { curvature, distance_fact, number_of_stops, unique_stops, distance_geo };
 }
 
 // Получение информации о маршруте
@@ -287,49 +592,444 @@ optional<BusStat> TransportCatalogue::GetBusInfo(string_view bus_name) const {
 	}
 
 	// Информация об остановках на маршруте и георгафической длине маршрута
-	return StopsCount(bus_ptr);
+	return bus_stats_[bus_ptr->id_];
+}
+
+// Построение сценария по названиям закрытых остановок и маршрутов
+Closures TransportCatalogue::MakeClosures(const vector<string>& stop_names, const vector<string>& bus_names) const {
+	Closures result;
+	result.closed_stops.assign(all_stops_.size(), false);
+	result.closed_buses.assign(all_buses_.size(), false);
+
+	for (const string& name : stop_names) {
+		if (const Stop* stop_ptr = GetStopByName(name)) {
+			result.closed_stops[stop_ptr->id_] = true;
+		}
+	}
+
+	for (const string& name : bus_names) {
+		if (const Bus* bus_ptr = GetBusByName(name)) {
+			result.closed_buses[bus_ptr->id_] = true;
+		}
+	}
+
+	return result;
+}
+
+// Информация о маршруте в сценарии с закрытыми остановками и маршрутами
+optional<BusStat> TransportCatalogue::GetBusInfo(string_view bus_name, const Closures& closures) const {
+	const Bus* bus_ptr = GetBusByName(bus_name);
+
+	if (bus_ptr == nullptr || closures.IsClosed(bus_ptr)) {
+		return nullopt;
+	}
+
+	// Без закрытых остановок на маршруте подходит сохраненная статистика
+	const auto is_closed = [&closures](const Stop* stop_ptr) { return closures.IsClosed(stop_ptr); };
+	if (none_of(bus_ptr->stops_.begin(), bus_ptr->stops_.end(), is_closed)) {
+		return bus_stats_[bus_ptr->id_];
+	}
+
+	// Статистика считается по исходному списку остановок, база не меняется.
+	// Автобус проезжает закрытые и удаленные остановки без остановки
+	const auto is_excluded = [this, &closures](const Stop* stop_ptr) {
+		return closures.IsClosed(stop_ptr) || removed_stops_[stop_ptr->id_];
+	};
+
+	return StopsCount(MakeRouteLegs(bus_source_stops_[bus_ptr->id_], bus_ptr->is_circle_, is_excluded),
+		bus_ptr->is_circle_);
+}
+
+// Статистика маршрута из базы без поиска по названию
+const BusStat& TransportCatalogue::GetBusStat(const Bus* bus_ptr) const {
+	return bus_stats_.at(bus_ptr->id_);
+}
+
+// Расстояния от начала полного пути маршрута до каждой его позиции
+const vector<int>& TransportCatalogue::GetRouteDistances(const Bus* bus_ptr) const {
+	return bus_routes_.at(bus_ptr->id_).distances;
 }
 
 // Возврат списка указателей на все остановки
 vector<const Stop*> TransportCatalogue::GetStopList() const {
-	vector<const Stop*> result;
-	result.reserve(stops_list_.size());
+	UpdateSearch();
+	return sorted_stops_;
+}
 
-	for (auto& i : stops_list_) {
-		result.push_back(i.second);
+// Задание способа расчета географических расстояний с пересчетом статистики маршрутов
+void TransportCatalogue::SetDistanceMode(geo::DistanceMode mode) {
+	if (mode == distance_mode_) {
+		return;
 	}
 
-	sort(result.begin(), result.end(),
-		[](const Stop* left, const Stop* right)
-		{
-			return lexicographical_compare(
-				left->name_.begin(), left->name_.end(),
-				right->name_.begin(), right->name_.end());
-		});
+	distance_mode_ = mode;
+	for (const Bus& bus : all_buses_) {
+		if (!removed_buses_[bus.id_]) {
+			UpdateBusStat(&bus);
+		}
+	}
+}
 
-	return result;
+geo::DistanceMode TransportCatalogue::GetDistanceMode() const {
+	return distance_mode_;
 }
 
 // Возврат списка указателей на все маршруты
 vector<const Bus*> TransportCatalogue::GetBusList() const {
-	vector<const Bus*> result;
-	result.reserve(buses_list_.size());
+	UpdateSearch();
+	return sorted_buses_;
+}
+
+// Координаты и названия всех остановок по их номерам
+StopArrays TransportCatalogue::GetStopArrays() const {
+	return { stop_lats_.data(), stop_lngs_.data(), stop_names_.data(), stop_names_.size() };
+}
 
-	// Перенос данных из unordered_map в vector
-	for (auto& i : buses_list_) {
-		result.push_back(i.second);
+// Маршруты, по которым можно доехать от остановки from до остановки to без пересадок
+optional<vector<DirectBus>> TransportCatalogue::GetDirectBuses(string_view from, string_view to) const {
+	auto from_id = FindStopId(from);
+	auto to_id = FindStopId(to);
+	if (!from_id || !to_id) {
+		return nullopt;
 	}
 
-	// Сортировка по названию маршрута
-	sort(result.begin(), result.end(),
-		[](const Bus* left, const Bus* right)
-		{
-			return lexicographical_compare(
-				left->name_.begin(), left->name_.end(),
-				right->name_.begin(), right->name_.end());
-		});
+	UpdateSearch();
+
+	vector<DirectBus> result;
+	if (*from_id == *to_id) {
+		return result;
+	}
+
+	// Общие маршруты остановок находятся пересечением масок по словам
+	const uint64_t* from_bits = stop_bus_bits_.data() + *from_id * bus_words_;
+	const uint64_t* to_bits = stop_bus_bits_.data() + *to_id * bus_words_;
+
+	for (size_t word = 0; word < bus_words_; ++word) {
+		for (uint64_t common = from_bits[word] & to_bits[word]; common != 0; common &= common - 1) {
+			const size_t bus_id = word * 64 + LowestBit(common);
+			const BusRouteIndex& index = bus_routes_[bus_id];
+
+			// Позиции обеих остановок на маршруте, по возрастанию
+			auto from_range = equal_range(index.positions.begin(), index.positions.end(),
+				pair{ static_cast<uint32_t>(*from_id), 0u },
+				[](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+			auto to_range = equal_range(index.positions.begin(), index.positions.end(),
+				pair{ static_cast<uint32_t>(*to_id), 0u },
+				[](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+			if (from_range.first == from_range.second) {
+				continue;
+			}
+
+			// Для каждой позиции to лучшая поездка начинается с ближайшей
+			// предшествующей позиции from
+			optional<DirectBus> best;
+			auto from_it = from_range.first;
+			for (auto to_it = to_range.first; to_it != to_range.second; ++to_it) {
+				while (next(from_it) != from_range.second && next(from_it)->second < to_it->second) {
+					++from_it;
+				}
+				if (from_it == from_range.second || from_it->second > to_it->second) {
+					continue;
+				}
+
+				const int distance = index.distances[to_it->second] - index.distances[from_it->second];
+				const int span_count = static_cast<int>(to_it->second - from_it->second);
+				if (!best || distance < best->distance || (distance == best->distance && span_count < best->span_count)) {
+					best = DirectBus{ &all_buses_[bus_id], distance, span_count };
+				}
+			}
+
+			if (best) {
+				result.push_back(*best);
+			}
+		}
+	}
+
+	sort(result.begin(), result.end(), [](const DirectBus& lhs, const DirectBus& rhs) {
+		return NameLess(lhs.bus->name_, rhs.bus->name_);
+	});
+
+	return result;
+}
+
+// Расход памяти по частям каталога
+memory_usage::Report TransportCatalogue::GetMemoryUsage() const {
+	UpdateSearch();
+
+	memory_usage::Report result;
+
+	result["name_blocks"s] = names_.GetBlocksMemoryUsage();
+	result["name_set"s] = names_.GetNamesMemoryUsage();
+	result["stops"s] = memory_usage::Of(all_stops_);
+
+	result["buses"s] = memory_usage::Of(all_buses_);
+	result["route_stop_ids"s] = memory_usage::Of(route_stop_ids_);
+	result["bus_source_stops"s] = memory_usage::Of(bus_source_stops_);
+
+	result["stop_arrays"s] = { stop_names_.size(),
+		memory_usage::Bytes(stop_lats_) + memory_usage::Bytes(stop_lngs_) + memory_usage::Bytes(stop_names_)
+		+ memory_usage::Bytes(stop_sin_lats_) + memory_usage::Bytes(stop_cos_lats_) };
+
+	memory_usage::Usage stop_index = stop_index_.GetMemoryUsage();
+	memory_usage::Usage bus_index = bus_index_.GetMemoryUsage();
+	result["name_index"s] = { stop_index.count + bus_index.count, stop_index.bytes + bus_index.bytes };
+	result["new_names"s] = { new_stop_names_.size() + new_bus_names_.size(),
+		memory_usage::Bytes(new_stop_names_) + memory_usage::Bytes(new_bus_names_) };
+
+	result["removed_flags"s] = { removed_stops_.size() + removed_buses_.size(),
+		memory_usage::Bytes(removed_stops_) + memory_usage::Bytes(removed_buses_) };
+	result["bus_stats"s] = memory_usage::Of(bus_stats_);
+	result["stops_tree"s] = stops_tree_.GetMemoryUsage();
+	result["sorted_lists"s] = { sorted_stops_.size() + sorted_buses_.size(),
+		memory_usage::Bytes(sorted_stops_) + memory_usage::Bytes(sorted_buses_) };
+
+	// Наборы маршрутов лежат внутри словаря
+	memory_usage::Usage& buses_to_stop = result["buses_to_stop"s] = memory_usage::Of(buses_to_stop_);
+	for (const auto& [stop, stop_buses] : buses_to_stop_) {
+		buses_to_stop.bytes += memory_usage::Bytes(stop_buses);
+	}
+
+	result["stop_distance"s] = memory_usage::Of(stop_distance_);
+	result["stop_bus_bits"s] = memory_usage::Of(stop_bus_bits_);
+
+	memory_usage::Usage& bus_routes = result["bus_routes"s] = memory_usage::Of(bus_routes_);
+	for (const BusRouteIndex& index : bus_routes_) {
+		bus_routes.bytes += memory_usage::Bytes(index.positions) + memory_usage::Bytes(index.distances);
+	}
+
+	return result;
+}
+
+// Поиск не более count остановок, ближайших к точке
+vector<NearestStop> TransportCatalogue::GetNearestStops(geo::Coordinates location, size_t count) const {
+	UpdateSearch();
+
+	vector<NearestStop> result;
+
+	for (const geo::NearestPoint& point : stops_tree_.FindNearest(location, count, distance_mode_)) {
+		result.push_back({ &all_stops_[point.id], point.distance });
+	}
 
 	return result;
 }
 
+// Поиск не более count остановок, названия которых начинаются с prefix
+vector<const Stop*> TransportCatalogue::SearchStops(string_view prefix, size_t count) const {
+	UpdateSearch();
+	return FindByPrefix(sorted_stops_, prefix, count);
+}
+
+// Поиск не более count маршрутов, названия которых начинаются с prefix
+vector<const Bus*> TransportCatalogue::SearchBuses(string_view prefix, size_t count) const {
+	UpdateSearch();
+	return FindByPrefix(sorted_buses_, prefix, count);
+}
+
+// Поиск остановки по имени. Если остановки нет, то выбрасывает исключение
+const Stop* TransportCatalogue::FindStop(string_view stop_name) const {
+	if (const Stop* stop = GetStopByName(stop_name)) {
+		return stop;
+	}
+
+	throw out_of_range("Unknown stop: "s + string(stop_name));
+}
+
+// Поиск номера остановки по индексу названий и по новым названиям
+optional<size_t> TransportCatalogue::FindStopId(string_view stop_name) const {
+	if (auto id = FindByIndex(stop_index_, all_stops_, removed_stops_, stop_name)) {
+		return id;
+	}
+
+	if (auto it = new_stop_names_.find(stop_name); it != new_stop_names_.end() && !removed_stops_[it->second]) {
+		return it->second;
+	}
+
+	return nullopt;
+}
+
+// Поиск номера маршрута по индексу названий и по новым названиям
+optional<size_t> TransportCatalogue::FindBusId(string_view bus_name) const {
+	if (auto id = FindByIndex(bus_index_, all_buses_, removed_buses_, bus_name)) {
+		return id;
+	}
+
+	if (auto it = new_bus_names_.find(bus_name); it != new_bus_names_.end() && !removed_buses_[it->second]) {
+		return it->second;
+	}
+
+	return nullopt;
+}
+
+// Добавление остановки без перестроения индекса названий
+Stop* TransportCatalogue::PushStop(Stop&& stop) {
+	// Переносим название в арену каталога
+	stop.name_ = names_.Intern(stop.name_);
+	stop.id_ = static_cast<uint32_t>(all_stops_.size());
+	removed_stops_.push_back(false);
+
+	stop_lats_.push_back(stop.location_.lat);
+	stop_lngs_.push_back(stop.location_.lng);
+
+	const geo::LatitudeTrig trig = geo::ComputeLatitudeTrig(stop.location_.lat);
+	stop_sin_lats_.push_back(trig.sin_lat);
+	stop_cos_lats_.push_back(trig.cos_lat);
+	stop_names_.push_back(stop.name_);
+
+	// Добавляем остановку в массив
+	Stop* ptr = &all_stops_.emplace_back(move(stop));
+
+	// Добавляем остановку в словарь остановок со списком маршрутов
+	buses_to_stop_[ptr];
+
+	return ptr;
+}
+
+// Добавление маршрута без перестроения индекса названий
+Bus* TransportCatalogue::PushBus(string_view name, bool is_circle, const vector<const Stop*>& stops) {
+	// Создаем узел Bus
+	Bus bus;
+
+	// Присваиваем имя и тип маршрута
+	bus.name_ = names_.Intern(name);
+	bus.is_circle_ = is_circle;
+	bus.id_ = static_cast<uint32_t>(all_buses_.size());
+	removed_buses_.push_back(false);
+	bus_stats_.emplace_back();
+	bus_routes_.emplace_back();
+
+	// Номера остановок записываются в конец общего массива
+	const size_t offset = route_stop_ids_.size();
+	for (const Stop* stop_ptr : stops) {
+		route_stop_ids_.push_back(stop_ptr->id_);
+	}
+	bus.stops_ = StopSequence(&route_stop_ids_, offset, stops.size(), &all_stops_);
+	bus_source_stops_.push_back(bus.stops_);
+
+	// Добавляем маршрут в массив с маршрутами
+	Bus* bus_ptr = &all_buses_.emplace_back(move(bus));
+
+	// Обновляем словарь остановок со списком маршрутов
+	for (const Stop* stop_ptr : stops) {
+		buses_to_stop_[stop_ptr].insert(bus_ptr);
+	}
+
+	return bus_ptr;
+}
+
+// Запись нового списка остановок маршрута в общий массив номеров остановок. Пока маршрут
+// ссылается на исходный список, и если новый список длиннее текущего, он записывается
+// в конец массива, иначе - на место текущего
+void TransportCatalogue::SetBusStops(Bus& bus, const vector<const Stop*>& stops) {
+	size_t offset = bus.stops_.GetOffset();
+	if (offset == bus_source_stops_[bus.id_].GetOffset() || stops.size() > bus.stops_.size()) {
+		offset = route_stop_ids_.size();
+		route_stop_ids_.resize(offset + stops.size());
+	}
+
+	for (size_t i = 0; i < stops.size(); ++i) {
+		route_stop_ids_[offset + i] = stops[i]->id_;
+	}
+
+	bus.stops_ = StopSequence(&route_stop_ids_, offset, stops.size(), &all_stops_);
+}
+
+// Перестроение индекса названий остановок
+void TransportCatalogue::RebuildStopIndex() {
+	stop_index_ = BuildIndex(all_stops_, removed_stops_);
+	new_stop_names_.clear();
+}
+
+// Перестроение индекса названий маршрутов
+void TransportCatalogue::RebuildBusIndex() {
+	bus_index_ = BuildIndex(all_buses_, removed_buses_);
+	new_bus_names_.clear();
+}
+
+// Перестроение пространственного индекса и списка остановок, отсортированного по названию
+void TransportCatalogue::RebuildStopSearch() const {
+	sorted_stops_ = SortByName(all_stops_, removed_stops_);
+
+	stops_tree_ = geo::KdTree(stop_lats_.data(), stop_lngs_.data(), stop_lats_.size());
+
+	for (const Stop& stop : all_stops_) {
+		if (removed_stops_[stop.id_]) {
+			stops_tree_.Remove(stop.id_);
+		}
+	}
+}
+
+// Пересчет списка остановок без удаленных, статистики и индекса позиций остановок маршрута
+void TransportCatalogue::UpdateBusStat(const Bus* bus_ptr) {
+	const RouteLegs legs = GetRouteLegs(bus_ptr);
+
+	const StopSequence& stops = bus_ptr->stops_;
+	if (!equal(stops.begin(), stops.end(), legs.stops.begin(), legs.stops.end())) {
+		SetBusStops(all_buses_[bus_ptr->id_], legs.stops);
+	}
+
+	bus_stats_[bus_ptr->id_] = StopsCount(legs, bus_ptr->is_circle_);
+
+	// Полный список остановок: линейный маршрут проходится туда и обратно
+	const StopSequence route = bus_ptr->GetRoute();
+
+	BusRouteIndex& index = bus_routes_[bus_ptr->id_];
+	index.positions.clear();
+	index.distances.clear();
+	index.positions.reserve(route.size());
+	index.distances.reserve(route.size());
+
+	// Расстояния между соседними остановками берутся из участков маршрута. Обратный
+	// ход линейного маршрута проходит участки в обратном порядке
+	const size_t list_size = legs.stops.size();
+	int distance = 0;
+	for (size_t i = 0; i < route.size(); ++i) {
+		if (i > 0) {
+			distance += i < list_size ? legs.forward[i - 1] : legs.backward[2 * list_size - 2 - i];
+		}
+		index.positions.emplace_back(route[i]->id_, static_cast<uint32_t>(i));
+		index.distances.push_back(distance);
+	}
+
+	sort(index.positions.begin(), index.positions.end());
+}
+
+// Перестроение битовых масок маршрутов по остановкам
+void TransportCatalogue::RebuildStopBusBits() const {
+	bus_words_ = (all_buses_.size() + 63) / 64;
+	stop_bus_bits_.assign(all_stops_.size() * bus_words_, 0);
+
+	for (const Bus& bus : all_buses_) {
+		if (removed_buses_[bus.id_]) {
+			continue;
+		}
+
+		for (const Stop* stop_ptr : bus.stops_) {
+			stop_bus_bits_[stop_ptr->id_ * bus_words_ + bus.id_ / 64] |= uint64_t(1) << (bus.id_ % 64);
+		}
+	}
+}
+
+// Перестроение списка маршрутов, отсортированного по названию
+void TransportCatalogue::RebuildBusSearch() const {
+	sorted_buses_ = SortByName(all_buses_, removed_buses_);
+}
+
+// Перестроение поисковых структур после добавления остановок и маршрутов
+void TransportCatalogue::UpdateSearch() const {
+	if (!search_outdated_.load(memory_order_acquire)) {
+		return;
+	}
+
+	lock_guard guard(search_mutex_);
+	if (!search_outdated_.load(memory_order_relaxed)) {
+		return;
+	}
+
+	RebuildStopSearch();
+	RebuildBusSearch();
+	RebuildStopBusBits();
+
+	search_outdated_.store(false, memory_order_release);
+}
+
 } // End Of transport_catalog
\ No newline at end of file
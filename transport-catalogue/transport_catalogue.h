@@ -2,6 +2,10 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "memory_usage.h"
+#include "name_arena.h"
+#include "name_index.h"
+#include "spatial_index.h"
 
 
 #include <deque>
@@ -13,7 +17,11 @@
 #include <set>
 #include <optional>
 #include <map>
+#include <cstdint>
 #include <utility>
+#include <atomic>
+#include <functional>
+#include <mutex>
 
 
 namespace transport_catalogue {
@@ -21,16 +29,30 @@ namespace transport_catalogue {
 
 class TransportCatalogue {
 public:
-	// Добавление остановки в базу
+	// Добавление остановки в базу. Новое название ищется в дополнительном словаре, пока
+	// индекс названий не перестроится. Поисковые структуры перестраиваются один раз
+	// при первом запросе после добавления
 	void AddStop(Stop&& stop);
 
-	// Добавление маршрута в базу
+	// Добавление маршрута в базу. Индекс названий и поисковые структуры обновляются
+	// так же, как при добавлении остановки
 	void AddBus(std::string_view name, bool is_circle, std::vector<std::string_view>& stops);
 	void AddBus(const BusToAdd& bus_to_add);
 
-	// Заполнение базы из набора данных
+	// Заполнение базы из набора данных. Индексы названий строятся после добавления
+	// всех остановок и всех маршрутов
 	void FillCatalogue(const std::deque<StopToAdd>& stops_to_add, const std::deque<BusToAdd>& buses_to_add);
 
+	// Заполнение базы из набора данных с готовыми индексами названий из базы.
+	// Если индексы не соответствуют данным, то они строятся заново
+	void FillCatalogue(const std::deque<StopToAdd>& stops_to_add, const std::deque<BusToAdd>& buses_to_add,
+		NameIndex name_index);
+
+	// Способ расчета географических расстояний для извилистости маршрутов и поиска
+	// ближайших остановок. Статистика уже добавленных маршрутов пересчитывается
+	void SetDistanceMode(geo::DistanceMode mode);
+	geo::DistanceMode GetDistanceMode() const;
+
 	// Поиск остановки по имени. Возвращает указатель на остановку
 	// Если остановки нет, то возвращает нулевой указатель
 	const Stop* GetStopByName(std::string_view stop_name) const;
@@ -44,52 +66,227 @@ public:
 	//const std::set<std::string_view>* FindStop(std::string_view stop_name) const;
 	const std::set<const Bus*>* GetBusesToStop(std::string_view stop_name) const;
 
-	// Задание дистанции между остановками
-	void SetDistance(StopsDistance& distance);
+	// Задание дистанции между остановками. Статистика маршрутов, в длину которых входит
+	// это расстояние, пересчитывается. Возвращает список таких маршрутов.
+	// Граф и маршрутизатор снимка обновляются по маршрутам, которые возвращают
+	// SetDistance, RemoveStop и RemoveBus (см. snapshot::Snapshot)
+	std::vector<const Bus*> SetDistance(const StopsDistance& distance);
+
+	// Удаление остановки. Остановка исключается из всех проходящих через нее маршрутов,
+	// статистика этих маршрутов пересчитывается. Автобус проезжает удаленную остановку
+	// без остановки, поэтому длина маршрута не меняется. Возвращает список измененных
+	// маршрутов или nullopt, если остановки нет
+	std::optional<std::vector<const Bus*>> RemoveStop(std::string_view stop_name);
+
+	// Удаление маршрута. Возвращает указатель на удаленный маршрут, который остается
+	// валидным до разрушения каталога, или нулевой указатель, если маршрута нет
+	const Bus* RemoveBus(std::string_view bus_name);
 
 	// Получение физического расстояния между остановками из словаря. Возвращает ноль,
 	// если ищется одна и та же остановка, или такой пары остановок нет
 	int GetDistance(std::string_view stop1, std::string_view stop2) const;
 
-	// Получение информации о маршруте
+	// Получение информации о маршруте. Статистика рассчитывается при заполнении базы
+	// и обновляется при ее изменении
 	std::optional<BusStat> GetBusInfo(std::string_view bus_name) const;
 
 	// Возврат сортированного списка указателей на все остановки
 	std::vector<const Stop*> GetStopList() const;
 
+	// Построение сценария по названиям закрытых остановок и маршрутов.
+	// Названия, которых нет в базе, пропускаются
+	Closures MakeClosures(const std::vector<std::string>& stop_names, const std::vector<std::string>& bus_names) const;
+
+	// Информация о маршруте в сценарии: закрытый маршрут не найден, а закрытые
+	// остановки исключаются из маршрута так же, как при удалении остановки.
+	// Расстояния через закрытую остановку входят в длину маршрута
+	std::optional<BusStat> GetBusInfo(std::string_view bus_name, const Closures& closures) const;
+
+	// Статистика маршрута из базы без поиска по названию
+	const BusStat& GetBusStat(const Bus* bus_ptr) const;
+
+	// Расстояния по дорогам от начала полного пути маршрута (Bus::GetRoute) до каждой
+	// его позиции. Участки через удаленные остановки включают путь через них
+	const std::vector<int>& GetRouteDistances(const Bus* bus_ptr) const;
+
 	// Возврат сортированного списка указателей на все маршуры
 	std::vector<const Bus*> GetBusList() const;
 
+	// Координаты и названия всех остановок по их номерам
+	StopArrays GetStopArrays() const;
+
+	// Координаты остановок с тригонометрией широты для пакетного расчета расстояний
+	geo::PointArrays GetStopPoints() const;
+
+	// Маршруты, по которым можно доехать от остановки from до остановки to без пересадок.
+	// Результат отсортирован по названию маршрута. Возвращает nullopt, если одной из
+	// остановок нет в базе
+	std::optional<std::vector<DirectBus>> GetDirectBuses(std::string_view from, std::string_view to) const;
+
+	// Поиск не более count остановок, ближайших к точке. Результат отсортирован по расстоянию
+	std::vector<NearestStop> GetNearestStops(geo::Coordinates location, size_t count) const;
+
+	// Поиск не более count остановок и маршрутов, названия которых начинаются с prefix.
+	// Результат отсортирован по названию
+	std::vector<const Stop*> SearchStops(std::string_view prefix, size_t count) const;
+	std::vector<const Bus*> SearchBuses(std::string_view prefix, size_t count) const;
+
+	// Расход памяти по частям каталога
+	memory_usage::Report GetMemoryUsage() const;
+
 private:
+	// Арена с названиями остановок и маршрутов. Объявлена первой, так как на
+	// ее строки ссылаются все остальные контейнеры
+	NameArena names_;
+
 	// Массив данных об остановках
 	std::deque<Stop> all_stops_;
 
 	// Массив данных о маршрутах
 	std::deque<Bus> all_buses_;
 
-	// Словарь указателей на остановки
-	std::unordered_map<std::string_view, Stop*> stops_list_;
+	// Номера остановок всех маршрутов подряд. Маршруты ссылаются на свои участки
+	std::vector<uint32_t> route_stop_ids_;
+
+	// Списки остановок маршрутов в том виде, в котором они заданы в базе, по номерам
+	// маршрутов. После удаления остановок Bus::stops_ ссылается на новый список,
+	// а длина маршрута по-прежнему считается по исходному
+	std::vector<StopSequence> bus_source_stops_;
+
+	// Широты, долготы и названия остановок по их номерам
+	std::vector<double> stop_lats_;
+	std::vector<double> stop_lngs_;
+	// Синусы и косинусы широт остановок для расчета расстояний
+	std::vector<double> stop_sin_lats_;
+	std::vector<double> stop_cos_lats_;
+	std::vector<std::string_view> stop_names_;
 
-	// Словарь указателей на маршруты
-	std::unordered_map<std::string_view, Bus*> buses_list_;
+	// Совершенные хеш-функции названий. Возвращают номер остановки в all_stops_
+	// и номер маршрута в all_buses_
+	PerfectHash stop_index_;
+	PerfectHash bus_index_;
+
+	// Названия, добавленные после построения индексов. Индекс перестраивается, когда
+	// таких названий становится больше, чем названий в нем, поэтому добавление по одному
+	// элементу обходится в среднем в постоянное время
+	std::unordered_map<std::string_view, uint32_t> new_stop_names_;
+	std::unordered_map<std::string_view, uint32_t> new_bus_names_;
+
+	// Признаки удаленных остановок и маршрутов по их номерам. Удаленные элементы
+	// остаются в массивах, чтобы указатели и номера остальных не менялись
+	std::vector<bool> removed_stops_;
+	std::vector<bool> removed_buses_;
+
+	// Статистика маршрутов по их номерам
+	std::vector<BusStat> bus_stats_;
+
+	// Способ расчета географических расстояний
+	geo::DistanceMode distance_mode_ = geo::DistanceMode::SPHERICAL;
+
+	// Позиции остановок на маршруте с учетом обратного хода линейного маршрута
+	struct BusRouteIndex {
+		// Пары (номер остановки, позиция), отсортированные по номеру остановки и позиции
+		std::vector<std::pair<uint32_t, uint32_t>> positions;
+		// Расстояние от начала маршрута до остановки на каждой позиции
+		std::vector<int> distances;
+	};
+
+	// Индексы позиций остановок по номерам маршрутов
+	std::vector<BusRouteIndex> bus_routes_;
+
+	// Наборы маршрутов по остановкам в виде битовых масок: у остановки установлен бит
+	// с номером маршрута, если маршрут через нее проходит. Маска остановки занимает
+	// bus_words_ слов, начиная с позиции (номер остановки * bus_words_)
+	mutable std::vector<uint64_t> stop_bus_bits_;
+	mutable size_t bus_words_ = 0;
+
+	// Пространственный индекс остановок. Номер точки - номер остановки в all_stops_
+	mutable geo::KdTree stops_tree_;
+
+	// Списки остановок и маршрутов, отсортированные по названию
+	mutable std::vector<const Stop*> sorted_stops_;
+	mutable std::vector<const Bus*> sorted_buses_;
+
+	// Признак того, что после AddStop или AddBus поисковые структуры (битовые маски,
+	// пространственный индекс и отсортированные списки) устарели. Они перестраиваются
+	// под блокировкой при первом обращении, поэтому каталог можно читать из нескольких потоков
+	mutable std::atomic<bool> search_outdated_ = false;
+	mutable std::mutex search_mutex_;
 
 	// Словарь списков маршрутов по остановкам
 	//std::unordered_map<Stop*, std::set<std::string_view>> buses_to_stop_;
-	std::unordered_map<Stop*, std::set<const Bus*>> buses_to_stop_;
+	std::unordered_map<const Stop*, std::set<const Bus*>> buses_to_stop_;
 
 	// Хеш функция для работы с парой указателей
 	struct HasherDistance {
-		size_t operator()(const std::pair<Stop*, Stop*>& stop_names) const {
+		size_t operator()(const std::pair<const Stop*, const Stop*>& stop_names) const {
 			return size_t(stop_names.first) + 101 * size_t(stop_names.second);
 		}
 	};
 
 	// Словарь расстояний между остановками
-	std::unordered_map<std::pair<Stop*, Stop*>, int, HasherDistance> stop_distance_;
+	std::unordered_map<std::pair<const Stop*, const Stop*>, int, HasherDistance> stop_distance_;
+
+	// Поиск остановки по имени. Если остановки нет, то выбрасывает исключение
+	const Stop* FindStop(std::string_view stop_name) const;
+
+	// Поиск номеров остановки и маршрута по индексу названий и по новым названиям
+	std::optional<size_t> FindStopId(std::string_view stop_name) const;
+	std::optional<size_t> FindBusId(std::string_view bus_name) const;
+
+	// Добавление данных без перестроения индексов названий
+	Stop* PushStop(Stop&& stop);
+	Bus* PushBus(std::string_view name, bool is_circle, const std::vector<const Stop*>& stops);
+
+	// Запись нового списка остановок маршрута в общий массив номеров остановок.
+	// Исходный список маршрута не перезаписывается
+	void SetBusStops(Bus& bus, const std::vector<const Stop*>& stops);
+
+	// Перестроение индексов названий по текущему содержимому базы
+	void RebuildStopIndex();
+	void RebuildBusIndex();
+
+	// Пересчет списка остановок без удаленных, статистики и индекса позиций остановок маршрута
+	void UpdateBusStat(const Bus* bus_ptr);
+
+	// Перестроение битовых масок маршрутов по остановкам
+	void RebuildStopBusBits() const;
+
+	// Перестроение поисковых структур, если они устарели
+	void UpdateSearch() const;
+
+	// Проверка, что расстояние от stop1_ptr до stop2_ptr входит в длину маршрута
+	bool UsesDistance(const Bus& bus, const Stop* stop1_ptr, const Stop* stop2_ptr) const;
+
+	// Расстояние между остановками. 0, если расстояние не задано
+	int DistanceBetween(const Stop* stop1_ptr, const Stop* stop2_ptr) const;
+
+	// Перестроение поисковых структур: пространственного индекса и отсортированных списков
+	void RebuildStopSearch() const;
+	void RebuildBusSearch() const;
+
+	// Остановки маршрута без исключенных и участки между соседними остановками
+	struct RouteLegs {
+		std::vector<const Stop*> stops;
+		// Дорожные расстояния участков туда и обратно и их географические длины.
+		// Участок через исключенные остановки включает весь путь через них
+		std::vector<int> forward;
+		std::vector<int> backward;
+		std::vector<double> geo;
+	};
+
+	// Участки маршрута по исходному списку остановок. Если задан excluded, то исключенные
+	// остановки пропускаются, соседние одинаковые остановки склеиваются, а кольцевой
+	// маршрут остается замкнутым
+	RouteLegs MakeRouteLegs(const StopSequence& stops, bool is_circle,
+		const std::function<bool(const Stop*)>& excluded) const;
+
+	// Участки маршрута без удаленных остановок
+	RouteLegs GetRouteLegs(const Bus* bus_ptr) const;
 
 	// Расчет количества остановок на маршруте и географическую длину
 	// Возврат (общее, уникальное, расстояние, извилистость)
-	BusStat StopsCount(const Bus* bus_ptr) const;
+	BusStat StopsCount(const RouteLegs& legs, bool is_circle) const;
 
 };
 
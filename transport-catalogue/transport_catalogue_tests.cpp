@@ -0,0 +1,333 @@
+#include "analytics.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace transport_catalogue;
+
+namespace {
+
+// Количество проваленных проверок
+int failures = 0;
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& actual, const U& expected, string_view actual_str, string_view expected_str,
+	string_view file, int line) {
+	if (actual != expected) {
+		cerr << file << "("sv << line << "): ASSERT_EQUAL("sv << actual_str << ", "sv << expected_str
+			<< ") failed: "sv << actual << " != "sv << expected << endl;
+		++failures;
+	}
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __LINE__)
+
+template <typename T, typename U>
+void AssertLessEqualImpl(const T& actual, const U& bound, string_view actual_str, string_view bound_str,
+	string_view file, int line) {
+	if (!(actual <= bound)) {
+		cerr << file << "("sv << line << "): ASSERT_LESS_EQUAL("sv << actual_str << ", "sv << bound_str
+			<< ") failed: "sv << actual << " > "sv << bound << endl;
+		++failures;
+	}
+}
+
+#define ASSERT_LESS_EQUAL(a, b) AssertLessEqualImpl((a), (b), #a, #b, __FILE__, __LINE__)
+
+// Допустимые ошибки приближенных способов относительно сферического на отрезках
+// от 50 м до 20 км: формула гаверсинусов отличается только округлением (до 1 мм),
+// равнопромежуточная проекция - не больше чем на 0.001% длины отрезка
+constexpr double HAVERSINE_MAX_ABS_ERROR = 1e-3;
+constexpr double EQUIRECTANGULAR_MAX_REL_ERROR = 1e-5;
+
+// Конец отрезка длиной length метров от точки from по направлению bearing градусов
+geo::Coordinates MoveBy(geo::Coordinates from, double length, double bearing) {
+	constexpr double METERS_PER_DEGREE = 6371000.0 * 3.1415926535 / 180.0;
+	const double angle = bearing * 3.1415926535 / 180.0;
+	const double cos_lat = cos(from.lat * 3.1415926535 / 180.0);
+	return { from.lat + length * cos(angle) / METERS_PER_DEGREE,
+		from.lng + length * sin(angle) / (METERS_PER_DEGREE * cos_lat) };
+}
+
+// Линейный маршрут A - B с расстоянием 1000 м между остановками
+void FillLinearBus(TransportCatalogue& catalogue, deque<pair<string, int>> a_distances) {
+	a_distances.emplace_back("B"s, 1000);
+
+	deque<StopToAdd> stops{
+		{ "A"s, { 55.60, 37.60 }, move(a_distances) },
+		{ "B"s, { 55.61, 37.61 }, {} } };
+	deque<BusToAdd> buses{ { false, "L"s, { "A"s, "B"s } } };
+
+	catalogue.FillCatalogue(stops, buses);
+}
+
+// Расстояние от конечной остановки до нее самой входит в длину линейного маршрута,
+// поэтому его изменение пересчитывает статистику маршрута
+void TestSetDistanceUpdatesTerminalSelfDistance() {
+	TransportCatalogue catalogue;
+	FillLinearBus(catalogue, {});
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 2000);
+
+	const auto changed = catalogue.SetDistance({ 500, "A"sv, "A"sv });
+	ASSERT_EQUAL(changed.size(), 1u);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 2500);
+
+	// Тот же результат, что и у базы, построенной заново
+	TransportCatalogue rebuilt;
+	FillLinearBus(rebuilt, { { "A"s, 500 } });
+	ASSERT_EQUAL(rebuilt.GetBusInfo("L"sv)->route_length, 2500);
+}
+
+// Расстояние в обратную сторону заменяет для обратного хода расстояние без пары
+void TestSetDistanceUpdatesReverseDistance() {
+	TransportCatalogue catalogue;
+	FillLinearBus(catalogue, {});
+
+	const auto changed = catalogue.SetDistance({ 300, "B"sv, "A"sv });
+	ASSERT_EQUAL(changed.size(), 1u);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 1300);
+
+	ASSERT_EQUAL(catalogue.SetDistance({ 700, "B"sv, "B"sv }).size(), 1u);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 2000);
+}
+
+// Маршрут через остановку X: A - X - C, линейный "L" или кольцевой "K"
+void FillBusThroughStop(TransportCatalogue& catalogue, bool is_circle) {
+	deque<StopToAdd> stops{
+		{ "A"s, { 55.60, 37.60 }, { { "X"s, 1000 } } },
+		{ "X"s, { 55.61, 37.61 }, { { "C"s, 2000 } } },
+		{ "C"s, { 55.62, 37.60 }, { { "A"s, 1500 } } } };
+	deque<BusToAdd> buses;
+	if (is_circle) {
+		buses.push_back({ true, "K"s, { "A"s, "X"s, "C"s, "A"s } });
+	}
+	else {
+		buses.push_back({ false, "L"s, { "A"s, "X"s, "C"s } });
+	}
+
+	catalogue.FillCatalogue(stops, buses);
+}
+
+// Автобус проезжает закрытую остановку без остановки, длина маршрута не меняется
+void TestClosedStopKeepsRouteLength() {
+	TransportCatalogue catalogue;
+	FillBusThroughStop(catalogue, false);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 6000);
+
+	const auto stat = catalogue.GetBusInfo("L"sv, catalogue.MakeClosures({ "X"s }, {}));
+	ASSERT_EQUAL(stat->route_length, 6000);
+	ASSERT_EQUAL(stat->stop_count, 3);
+	ASSERT_EQUAL(stat->unique_stop_count, 2);
+}
+
+// Закрытая первая остановка кольцевого маршрута: маршрут замыкается через нее
+void TestClosedFirstStopKeepsCircle() {
+	TransportCatalogue catalogue;
+	FillBusThroughStop(catalogue, true);
+	ASSERT_EQUAL(catalogue.GetBusInfo("K"sv)->route_length, 4500);
+
+	const auto stat = catalogue.GetBusInfo("K"sv, catalogue.MakeClosures({ "A"s }, {}));
+	ASSERT_EQUAL(stat->route_length, 4500);
+	ASSERT_EQUAL(stat->stop_count, 3);
+	ASSERT_EQUAL(stat->unique_stop_count, 2);
+}
+
+// Удаленная остановка исключается так же, как закрытая
+void TestRemovedStopKeepsRouteLength() {
+	TransportCatalogue catalogue;
+	FillBusThroughStop(catalogue, false);
+
+	const auto changed = catalogue.RemoveStop("X"sv);
+	ASSERT_EQUAL(changed->size(), 1u);
+
+	const auto stat = catalogue.GetBusInfo("L"sv);
+	ASSERT_EQUAL(stat->route_length, 6000);
+	ASSERT_EQUAL(stat->stop_count, 3);
+	ASSERT_EQUAL(stat->unique_stop_count, 2);
+
+	// Расстояние до удаленной остановки по-прежнему входит в маршрут
+	ASSERT_EQUAL(catalogue.SetDistance({ 500, "A"sv, "C"sv }).size(), 0u);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->route_length, 6000);
+
+	// Маршрут с одной оставшейся остановкой и без остановок
+	catalogue.RemoveStop("A"sv);
+	ASSERT_EQUAL(catalogue.GetBusInfo("L"sv)->stop_count, 1);
+
+	catalogue.RemoveStop("C"sv);
+	const auto empty_stat = catalogue.GetBusInfo("L"sv);
+	ASSERT_EQUAL(empty_stat->route_length, 0);
+	ASSERT_EQUAL(empty_stat->stop_count, 0);
+	ASSERT_EQUAL(empty_stat->unique_stop_count, 0);
+}
+
+// Остановку и маршрут, добавленные после заполнения базы и удаленные, можно добавить снова
+void TestReAddRemovedNames() {
+	TransportCatalogue catalogue;
+	FillLinearBus(catalogue, {});
+
+	catalogue.AddStop({ "X"sv, { 55.62, 37.62 } });
+	vector<string_view> stops{ "A"sv, "X"sv };
+	catalogue.AddBus("M"sv, false, stops);
+
+	catalogue.RemoveBus("M"sv);
+	catalogue.RemoveStop("X"sv);
+	ASSERT_EQUAL(catalogue.GetStopByName("X"sv) == nullptr, true);
+	ASSERT_EQUAL(catalogue.GetBusByName("M"sv) == nullptr, true);
+
+	catalogue.AddStop({ "X"sv, { 55.63, 37.63 } });
+	catalogue.AddBus("M"sv, false, stops);
+	ASSERT_EQUAL(catalogue.GetStopByName("X"sv) != nullptr, true);
+	ASSERT_EQUAL(catalogue.GetBusByName("M"sv) != nullptr, true);
+	ASSERT_EQUAL(catalogue.GetBusInfo("M"sv)->stop_count, 3);
+}
+
+// Вес кратчайшего пути маршрутизатора между остановками. -1, если пути нет
+double RouteWeight(const transport_router::TransportRouter& transport_router, const graph::Router<double>& router,
+	string_view from, string_view to) {
+	const auto route = router.BuildRoute(transport_router.GetVertexId(from), transport_router.GetVertexId(to));
+	return route ? route->weight : -1.0;
+}
+
+// Пути маршрутизатора между всеми остановками совпадают с путями маршрутизатора,
+// построенного по каталогу заново
+void AssertSameAsRebuilt(const TransportCatalogue& catalogue, const transport_router::TransportRouter& transport_router,
+	const graph::Router<double>& router, transport_router::RoutingSettings settings) {
+	const transport_router::TransportRouter rebuilt_transport_router(catalogue, settings);
+	const graph::Router<double> rebuilt_router(rebuilt_transport_router.GetGraph());
+
+	for (const Stop* from : catalogue.GetStopList()) {
+		for (const Stop* to : catalogue.GetStopList()) {
+			const double weight = RouteWeight(transport_router, router, from->name_, to->name_);
+			const double expected = RouteWeight(rebuilt_transport_router, rebuilt_router, from->name_, to->name_);
+			ASSERT_LESS_EQUAL(abs(weight - expected), 1e-9);
+		}
+	}
+}
+
+// Изменения каталога переносятся в граф и матрицу маршрутизатора заменой ребер
+// только измененных маршрутов
+void TestRouterFollowsCatalogueChanges() {
+	deque<StopToAdd> stops{
+		{ "A"s, { 55.60, 37.60 }, { { "C"s, 10000 }, { "D"s, 3000 } } },
+		{ "C"s, { 55.62, 37.62 }, {} },
+		{ "D"s, { 55.61, 37.63 }, { { "C"s, 3000 } } } };
+	deque<BusToAdd> buses{
+		{ false, "1"s, { "A"s, "C"s } },
+		{ false, "2"s, { "A"s, "D"s, "C"s } } };
+
+	TransportCatalogue catalogue;
+	catalogue.FillCatalogue(stops, buses);
+
+	// Ожидание 2 минуты, скорость 1000 м/мин
+	transport_router::RoutingSettings settings{ 2, 60.0 };
+	transport_router::TransportRouter transport_router(catalogue, settings);
+	graph::Router<double> router(transport_router.GetGraph());
+
+	auto update_buses = [&](const vector<const Bus*>& changed_buses) {
+		transport_router::EdgeChanges changes;
+		for (const Bus* bus : changed_buses) {
+			const transport_router::EdgeChanges bus_changes = transport_router.UpdateBus(bus);
+			changes.removed.insert(changes.removed.end(), bus_changes.removed.begin(), bus_changes.removed.end());
+			changes.added.insert(changes.added.end(), bus_changes.added.begin(), bus_changes.added.end());
+		}
+		router.UpdateEdges(changes.removed, changes.added);
+	};
+
+	ASSERT_EQUAL(RouteWeight(transport_router, router, "A"sv, "C"sv), 8.0);
+
+	// Путь от A маршрут 1 не использовал, поэтому сокращается через его новые ребра
+	update_buses(catalogue.SetDistance({ 1000, "A"sv, "C"sv }));
+	ASSERT_EQUAL(RouteWeight(transport_router, router, "A"sv, "C"sv), 3.0);
+	AssertSameAsRebuilt(catalogue, transport_router, router, settings);
+
+	// Путь от A до C проходил по старым ребрам маршрута 1 и строится заново
+	update_buses(catalogue.SetDistance({ 20000, "A"sv, "C"sv }));
+	ASSERT_EQUAL(RouteWeight(transport_router, router, "A"sv, "C"sv), 8.0);
+	AssertSameAsRebuilt(catalogue, transport_router, router, settings);
+
+	// Маршрут 2 проезжает удаленную остановку без остановки
+	update_buses(*catalogue.RemoveStop("D"sv));
+	ASSERT_EQUAL(RouteWeight(transport_router, router, "A"sv, "C"sv), 8.0);
+	AssertSameAsRebuilt(catalogue, transport_router, router, settings);
+
+	const Bus* removed_bus = catalogue.RemoveBus("2"sv);
+	router.UpdateEdges(transport_router.RemoveBus(removed_bus).removed, {});
+	ASSERT_EQUAL(RouteWeight(transport_router, router, "A"sv, "C"sv), 22.0);
+	AssertSameAsRebuilt(catalogue, transport_router, router, settings);
+}
+
+// Приближенные способы расчета расстояний на отрезках в пределах города на разных
+// широтах и по разным направлениям
+void TestApproximateDistancesWithinTolerance() {
+	for (double lat : { 0.0, 30.0, 43.0, 55.75, 60.0 }) {
+		for (double length : { 50.0, 200.0, 1000.0, 5000.0, 20000.0 }) {
+			for (int bearing = 0; bearing < 360; bearing += 15) {
+				const geo::Coordinates from{ lat, 37.6 };
+				const geo::Coordinates to = MoveBy(from, length, bearing);
+
+				const double reference = geo::ComputeDistance(from, to, geo::DistanceMode::SPHERICAL);
+				const double haversine = geo::ComputeDistance(from, to, geo::DistanceMode::HAVERSINE);
+				const double equirectangular = geo::ComputeDistance(from, to, geo::DistanceMode::EQUIRECTANGULAR);
+
+				ASSERT_LESS_EQUAL(abs(haversine - reference), HAVERSINE_MAX_ABS_ERROR);
+				ASSERT_LESS_EQUAL(abs(equirectangular - reference) / reference, EQUIRECTANGULAR_MAX_REL_ERROR);
+			}
+		}
+	}
+}
+
+// Отчет check_distance по отрезкам маршрутов базы укладывается в те же допуски
+void TestDistanceAccuracyReport() {
+	// Остановки по кругу радиусом 5 км вокруг центра города и кольцевой маршрут через них
+	deque<StopToAdd> stops;
+	BusToAdd bus{ true, "K"s, {} };
+	const geo::Coordinates center{ 55.75, 37.6 };
+	for (int bearing = 0; bearing < 360; bearing += 10) {
+		const string name = "S"s + to_string(bearing);
+		stops.push_back({ name, MoveBy(center, 5000.0, bearing), {} });
+		bus.stops.push_back(name);
+	}
+	bus.stops.push_back(bus.stops.front());
+
+	TransportCatalogue catalogue;
+	catalogue.FillCatalogue(stops, deque<BusToAdd>{ bus });
+
+	const analytics::DistanceAccuracy haversine = analytics::MeasureDistanceAccuracy(catalogue, geo::DistanceMode::HAVERSINE);
+	ASSERT_EQUAL(haversine.segment_count, stops.size());
+	ASSERT_LESS_EQUAL(haversine.max_abs_error, HAVERSINE_MAX_ABS_ERROR);
+
+	const analytics::DistanceAccuracy equirectangular = analytics::MeasureDistanceAccuracy(catalogue, geo::DistanceMode::EQUIRECTANGULAR);
+	ASSERT_EQUAL(equirectangular.segment_count, stops.size());
+	ASSERT_LESS_EQUAL(equirectangular.max_rel_error, EQUIRECTANGULAR_MAX_REL_ERROR);
+}
+
+} // End of namespace
+
+int main() {
+	TestSetDistanceUpdatesTerminalSelfDistance();
+	TestSetDistanceUpdatesReverseDistance();
+	TestClosedStopKeepsRouteLength();
+	TestClosedFirstStopKeepsCircle();
+	TestRemovedStopKeepsRouteLength();
+	TestReAddRemovedNames();
+	TestRouterFollowsCatalogueChanges();
+	TestApproximateDistancesWithinTolerance();
+	TestDistanceAccuracyReport();
+
+	if (failures != 0) {
+		cerr << failures << " check(s) failed"sv << endl;
+		return EXIT_FAILURE;
+	}
+
+	cerr << "All tests passed"sv << endl;
+	return EXIT_SUCCESS;
+}
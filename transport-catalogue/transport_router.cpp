@@ -26,7 +26,7 @@ RoutingSettings TransportRouter::GetRoutingSettings() const {
 }
 
 // Получение ссылки на граф
-const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() {
+const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
 	return graph_;
 }
 
@@ -45,6 +45,57 @@ double TransportRouter::GetRunTime(graph::EdgeId id) const {
 	return graph_.GetEdge(id).weight - routing_settings_.bus_wait_time;
 }
 
+// Время поездки на автобусе в минутах на расстояние в метрах без учета ожидания
+double TransportRouter::GetRideTime(double distance) const {
+	return distance / (routing_settings_.bus_velocity * 1000.0 / 60.0);
+}
+
+// Поиск маршрута в сценарии с закрытыми остановками и маршрутами
+optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to,
+	const transport_catalogue::Closures& closures) const {
+	// Вершина без остановки открыта
+	auto vertex_closed = [this, &closures](graph::VertexId vertex) {
+		return vertex < vertex_stops_.size() && closures.IsClosed(vertex_stops_[vertex]);
+	};
+
+	if (vertex_closed(from) || vertex_closed(to)) {
+		return nullopt;
+	}
+
+	return graph::BuildRouteFiltered(graph_, from, to, [&](graph::EdgeId edge_id) {
+		const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
+		return !closures.IsClosed(edge_id_to_edge_info_.at(edge_id).bus)
+			&& !vertex_closed(edge.from) && !vertex_closed(edge.to);
+	});
+}
+
+// Замена ребер маршрута после его изменения в каталоге
+EdgeChanges TransportRouter::UpdateBus(const transport_catalogue::Bus* bus) {
+	EdgeChanges changes = RemoveBus(bus);
+	AddBusEdges(bus);
+	changes.added = bus_edges_[bus];
+	return changes;
+}
+
+// Исключение ребер маршрута из графа
+EdgeChanges TransportRouter::RemoveBus(const transport_catalogue::Bus* bus) {
+	EdgeChanges changes;
+
+	auto it = bus_edges_.find(bus);
+	if (it == bus_edges_.end()) {
+		return changes;
+	}
+
+	for (const graph::EdgeId edge_id : it->second) {
+		graph_.RemoveEdge(edge_id);
+		edge_id_to_edge_info_.erase(edge_id);
+	}
+	changes.removed = move(it->second);
+	bus_edges_.erase(it);
+
+	return changes;
+}
+
 double TransportRouter::GetDistance(const graph::Router<double>::RouteInfo& info) const {
 	return info.weight;
 }
@@ -57,53 +108,76 @@ void TransportRouter::SetStopVertexId() {
 			// Если не добавлена, то создается пара имя - VertexID
 			// VertexId = размеру списка до добавления остановки
 			stop_name_to_vertex_id_[stop->name_] = stop_name_to_vertex_id_.size();
+			vertex_stops_.push_back(stop);
 		}
 	}
 }
 
 void TransportRouter::SetRoutesToGraph() {
 	for (const auto& bus : catalogue_.GetBusList()) {
-		// Нужно создать список остановок, в завивисимости от типа маршрута
-		// Просто список - для кольцевого, удвоенный - для некольцевого
-		// По этому списку и проходить при построении графа
+		AddBusEdges(bus);
+	}
+}
 
-		auto stop_list = bus->stops_;
+// Расход памяти по частям: граф и вспомогательные словари
+memory_usage::Report TransportRouter::GetMemoryUsage() const {
+	memory_usage::Report result;
 
-		if (!bus->is_circle_) {
-			stop_list.resize(bus->stops_.size() * 2 - 1);
-			reverse(stop_list.begin(), stop_list.end());
-			copy(bus->stops_.begin(), bus->stops_.end(), stop_list.begin());
-		}
+	result["graph_edges"s] = graph_.GetEdgesMemoryUsage();
+	result["graph_incidence_lists"s] = graph_.GetIncidenceMemoryUsage();
+	result["stop_name_to_vertex_id"s] = memory_usage::Of(stop_name_to_vertex_id_);
+	result["edge_id_to_edge_info"s] = memory_usage::Of(edge_id_to_edge_info_);
+
+	memory_usage::Usage& bus_edges = result["bus_edges"s] = memory_usage::Of(bus_edges_);
+	for (const auto& [bus, edges] : bus_edges_) {
+		bus_edges.bytes += memory_usage::Bytes(edges);
+	}
+
+	return result;
+}
+
+void TransportRouter::AddBusEdges(const transport_catalogue::Bus* bus) {
+	// Маршрут без остановок не добавляет ребер
+	if (bus->stops_.empty()) {
+		return;
+	}
+
+	// Полный путь маршрута: для кольцевого - список остановок, для некольцевого -
+	// список туда и обратно. Обратный ход получается без копирования списка
+	// По этому списку и проходить при построении графа
+	const transport_catalogue::StopSequence stop_list = bus->GetRoute();
+
+	// Расстояния от начала пути до каждой позиции. Участок через удаленную
+	// остановку включает путь через нее, как и длина маршрута в каталоге
+	const vector<int>& route_distances = catalogue_.GetRouteDistances(bus);
 
-		// Хранилища названий остановок
-		string second_stop, prev_stop;
+	// Ссылка на название остановки
+	string_view second_stop;
 
-		// Проход по списку остановок
-		// Внешний цикл задает первую остановку для ребра. Внутренний - конечную
+	auto& bus_edges = bus_edges_[bus];
 
-		// Проход по списку остановок
-		// Внешний цикл задает первую остановку для ребра. Внутренний - конечную
-		for (int start = 0; start < stop_list.size(); ++start) {
-			double road_time_min = 0;
-			int span_count = 0;
-			for (int end = start + 1; end < stop_list.size(); ++end) {
-				second_stop = stop_list[end]->name_;
-				prev_stop = stop_list[end - 1]->name_;
+	// Проход по списку остановок
+	// Внешний цикл задает первую остановку для ребра. Внутренний - конечную
+	for (int start = 0; start < stop_list.size(); ++start) {
+		double road_time_min = 0;
+		int span_count = 0;
+		for (int end = start + 1; end < stop_list.size(); ++end) {
+			second_stop = stop_list[end]->name_;
 
-				double distance = catalogue_.GetDistance(prev_stop, second_stop);
-				double speed_m_per_min = routing_settings_.bus_velocity * 1000.0 / 60.0;
-				road_time_min += distance / speed_m_per_min;
+			double distance = route_distances[end] - route_distances[end - 1];
+			double speed_m_per_min = routing_settings_.bus_velocity * 1000.0 / 60.0;
+			road_time_min += distance / speed_m_per_min;
 
-				graph::Edge<double> edge_to_add;
-				edge_to_add.from = stop_name_to_vertex_id_[stop_list[start]->name_];
-				edge_to_add.to = stop_name_to_vertex_id_[second_stop];
-				edge_to_add.weight = road_time_min + routing_settings_.bus_wait_time;
+			graph::Edge<double> edge_to_add;
+			edge_to_add.from = GetVertexId(stop_list[start]->name_);
+			edge_to_add.to = GetVertexId(second_stop);
+			edge_to_add.weight = road_time_min + routing_settings_.bus_wait_time;
 
-				graph::EdgeId edge_id = graph_.AddEdge(std::move(edge_to_add));
+			graph::EdgeId edge_id = graph_.AddEdge(std::move(edge_to_add));
+			bus_edges.push_back(edge_id);
 
-				span_count++;
-				edge_id_to_edge_info_[edge_id] = { bus->name_, stop_list[start]->name_, second_stop, span_count };
-			}
+			span_count++;
+			edge_id_to_edge_info_[edge_id] = { bus, bus->name_, stop_list[start]->name_, second_stop, span_count };
 		}
 	}
 }
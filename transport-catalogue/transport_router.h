@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <string_view>
 #include <optional>
+#include <vector>
 
 namespace transport_router {
 
@@ -18,8 +19,8 @@ struct RoutingSettings{
 
 struct RouteElement {
 	std::string type;
-	std::string stop_name;
-	std::string bus_name;
+	std::string_view stop_name;
+	std::string_view bus_name;
 	double time{};
 	int span_count{};
 };
@@ -31,13 +32,22 @@ struct RouteResponce {
 	double bus_wait_time{};
 };
 
+// Свойства ребра графа. Названия ссылаются на арену названий каталога
 struct EdgeInfo {
-	std::string bus_name;
-	std::string start;
-	std::string finish;
+	const transport_catalogue::Bus* bus = nullptr;
+	std::string_view bus_name;
+	std::string_view start;
+	std::string_view finish;
 	int span_count = 0;
 };
 
+// Ребра графа, исключенные и добавленные при замене ребер маршрутов. По ним
+// обновляется матрица graph::Router
+struct EdgeChanges {
+	std::vector<graph::EdgeId> removed;
+	std::vector<graph::EdgeId> added;
+};
+
 
 // Переделка класса для оптимизации алгоритма заполения графа
 
@@ -52,7 +62,7 @@ public:
 	RoutingSettings GetRoutingSettings() const;
 
 	// Получение ссылки на граф
-	const graph::DirectedWeightedGraph<double>& GetGraph();
+	const graph::DirectedWeightedGraph<double>& GetGraph() const;
 
 	// Получение ссылки на свойства ребра по его EdgeId
 	const EdgeInfo& GetEdgeInfo(graph::EdgeId id) const;
@@ -63,23 +73,49 @@ public:
 	// Получение времени перемещения между остановками
 	double GetRunTime(graph::EdgeId id) const;
 
+	// Время поездки на автобусе в минутах на расстояние в метрах без учета ожидания
+	double GetRideTime(double distance) const;
+
+	// Поиск маршрута в сценарии с закрытыми остановками и маршрутами. Общий граф не
+	// меняется: ребра закрытых маршрутов и ребра из закрытых остановок и в них пропускаются
+	std::optional<graph::Router<double>::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to,
+		const transport_catalogue::Closures& closures) const;
+
+	// Замена ребер маршрута после его изменения в каталоге: старые ребра исключаются
+	// из графа, новые строятся по текущему списку остановок и расстояниям маршрута.
+	// Ребра остальных маршрутов не меняются. Остановки маршрута должны быть в графе
+	EdgeChanges UpdateBus(const transport_catalogue::Bus* bus);
+
+	// Исключение ребер маршрута, удаленного из каталога
+	EdgeChanges RemoveBus(const transport_catalogue::Bus* bus);
+
 	// Метод возвращает значение длины ребра в double, вытаскивая его из 
 	// шаблонной структуры RouteInfo
 	double GetDistance(const graph::Router<double>::RouteInfo& info) const;
 
+	// Расход памяти по частям: граф и вспомогательные словари
+	memory_usage::Report GetMemoryUsage() const;
+
 private:
 	graph::DirectedWeightedGraph<double> graph_;
 	const transport_catalogue::TransportCatalogue& catalogue_;
 	RoutingSettings routing_settings_;
 
 	std::unordered_map<std::string_view, graph::VertexId> stop_name_to_vertex_id_;
+	// Остановки по VertexId
+	std::vector<const transport_catalogue::Stop*> vertex_stops_;
 	std::unordered_map<graph::EdgeId, EdgeInfo> edge_id_to_edge_info_;
+	// Ребра графа по маршрутам
+	std::unordered_map<const transport_catalogue::Bus*, std::vector<graph::EdgeId>> bus_edges_;
 
 	// Присвоение VertexId остановкам из каталога
 	void SetStopVertexId();
 
 	// Заполение графа маршрутами
 	void SetRoutesToGraph();
+
+	// Добавление в граф ребер одного маршрута
+	void AddBusEdges(const transport_catalogue::Bus* bus);
 };
 
 